@@ -38,6 +38,18 @@
 
 #include "RtMidi.h"
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32)
+  #include <malloc.h>
+#endif
 
 //*********************************************************************//
 //  RtMidi Definitions
@@ -185,6 +197,7 @@ void RtMidiOut :: openMidiApi( RtMidi::Api api, const std::string clientName )
 }
 
 RtMidiOut :: RtMidiOut( RtMidi::Api api, const std::string clientName )
+  : asyncData_( 0 )
 {
   if ( api != UNSPECIFIED ) {
     // Attempt to open the specified API.
@@ -217,6 +230,446 @@ RtMidiOut :: RtMidiOut( RtMidi::Api api, const std::string clientName )
 
 RtMidiOut :: ~RtMidiOut() throw()
 {
+  // Send what is still queued while the API is there.
+  setAsync( false );
+}
+
+//*********************************************************************//
+//  RtMidiOutQueue Definitions
+//*********************************************************************//
+
+// The size of a cache line, which the queue slots and positions are
+// aligned to so that two threads never write the same line.
+const size_t CACHE_LINE_SIZE = 64;
+
+// One message of the output queue, filling a cache line.  The
+// sequence tells the state of the slot for the position pos it is used
+// at: pos when it is free, pos + 1 once its message is written.
+struct alignas(CACHE_LINE_SIZE) OutQueueSlot {
+  std::atomic<unsigned int> sequence;
+  unsigned char size;
+  unsigned char bytes[RtMidiOutQueue::MAX_MESSAGE_SIZE];
+};
+
+struct OutQueueData {
+  OutQueueSlot *slots;
+  unsigned int mask;                      // capacity - 1
+  std::atomic<unsigned long> rejected;
+
+  // The producers and the consumer each write their own cache line.
+  alignas(CACHE_LINE_SIZE) std::atomic<unsigned int> enqueuePos;  // next position claimed by a producer
+  alignas(CACHE_LINE_SIZE) std::atomic<unsigned int> dequeuePos;  // next position drained
+};
+
+// Allocates \e size bytes on a cache line boundary (plain new only
+// honours the alignment of the types above from C++17 on).
+static void *allocateAligned( size_t size )
+{
+  void *memory = NULL;
+#if defined(_WIN32)
+  memory = _aligned_malloc( size, CACHE_LINE_SIZE );
+#else
+  if ( posix_memalign( &memory, CACHE_LINE_SIZE, size ) != 0 ) memory = NULL;
+#endif
+  if ( memory == NULL ) throw std::bad_alloc();
+  return memory;
+}
+
+static void freeAligned( void *memory )
+{
+#if defined(_WIN32)
+  _aligned_free( memory );
+#else
+  free( memory );
+#endif
+}
+
+RtMidiOutQueue :: RtMidiOutQueue( RtMidiOut *midiout, unsigned int capacity )
+  : midiout_( midiout )
+{
+  unsigned int size = 2;
+  while ( size < capacity && size < 0x80000000 ) size <<= 1;
+
+  OutQueueData *data = new ( allocateAligned( sizeof(OutQueueData) ) ) OutQueueData;
+  try {
+    data->slots = static_cast<OutQueueSlot *> (allocateAligned( size * sizeof(OutQueueSlot) ));
+  }
+  catch ( std::bad_alloc & ) {
+    data->~OutQueueData();
+    freeAligned( data );
+    throw;
+  }
+  data->mask = size - 1;
+  for ( unsigned int i = 0; i < size; i++ ) {
+    new ( &data->slots[i] ) OutQueueSlot;
+    data->slots[i].sequence.store( i, std::memory_order_relaxed );
+  }
+  data->enqueuePos.store( 0, std::memory_order_relaxed );
+  data->dequeuePos.store( 0, std::memory_order_relaxed );
+  data->rejected.store( 0, std::memory_order_relaxed );
+  queueData_ = (void *) data;
+
+  // Room for a full queue of 3-byte messages, so a drain seldom allocates.
+  batch_.reserve( size * 3 );
+}
+
+RtMidiOutQueue :: ~RtMidiOutQueue( void )
+{
+  OutQueueData *data = static_cast<OutQueueData *> (queueData_);
+  for ( unsigned int i = 0; i <= data->mask; i++ )
+    data->slots[i].~OutQueueSlot();
+  freeAligned( data->slots );
+  data->~OutQueueData();
+  freeAligned( data );
+}
+
+// Returns true if the \e size bytes at \e message are exactly one
+// complete message, so that a group of them can be split again.
+static bool isCompleteMessage( const unsigned char *message, size_t size )
+{
+  if ( size == 0 || message[0] < 0x80 ) return false;
+  if ( message[0] == 0xF0 )
+    return MidiOutApi::getMessageLength( message, (unsigned int) size ) == size && message[size - 1] == 0xF7;
+  return MidiOutApi::getMessageLength( message, 3 ) == size;
+}
+
+bool RtMidiOutQueue :: push( const unsigned char *message, size_t size )
+{
+  OutQueueData *data = static_cast<OutQueueData *> (queueData_);
+  if ( size > MAX_MESSAGE_SIZE || !isCompleteMessage( message, size ) ) {
+    data->rejected.fetch_add( 1, std::memory_order_relaxed );
+    return false;
+  }
+
+  // Claim the slot at enqueuePos, unless the drain has not freed it yet.
+  OutQueueSlot *slot;
+  unsigned int pos = data->enqueuePos.load( std::memory_order_relaxed );
+  for ( ;; ) {
+    slot = &data->slots[pos & data->mask];
+    int difference = (int) ( slot->sequence.load( std::memory_order_acquire ) - pos );
+    if ( difference == 0 ) {
+      if ( data->enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+        break;
+    }
+    else if ( difference < 0 ) {
+      data->rejected.fetch_add( 1, std::memory_order_relaxed );
+      return false;
+    }
+    else pos = data->enqueuePos.load( std::memory_order_relaxed );
+  }
+
+  slot->size = (unsigned char) size;
+  for ( size_t i = 0; i < size; i++ ) slot->bytes[i] = message[i];
+  slot->sequence.store( pos + 1, std::memory_order_release );
+  return true;
+}
+
+bool RtMidiOutQueue :: push( std::vector<unsigned char> *message )
+{
+  return push( message->empty() ? NULL : &(*message)[0], message->size() );
+}
+
+unsigned int RtMidiOutQueue :: drain( unsigned int maxMessages )
+{
+  OutQueueData *data = static_cast<OutQueueData *> (queueData_);
+  unsigned int pos = data->dequeuePos.load( std::memory_order_relaxed );
+  unsigned int count = 0;
+
+  // Gather the written messages, up to the first slot still being
+  // written, and free their slots for the lap after.
+  batch_.clear();
+  while ( maxMessages == 0 || count < maxMessages ) {
+    OutQueueSlot *slot = &data->slots[pos & data->mask];
+    if ( slot->sequence.load( std::memory_order_acquire ) != pos + 1 ) break;
+    batch_.insert( batch_.end(), slot->bytes, slot->bytes + slot->size );
+    slot->sequence.store( pos + data->mask + 1, std::memory_order_release );
+    pos++;
+    count++;
+  }
+  data->dequeuePos.store( pos, std::memory_order_relaxed );
+
+  if ( count > 0 && midiout_ ) midiout_->sendMessages( &batch_ );
+  return count;
+}
+
+unsigned int RtMidiOutQueue :: getCapacity( void ) const
+{
+  OutQueueData *data = static_cast<OutQueueData *> (queueData_);
+  return data->mask + 1;
+}
+
+unsigned int RtMidiOutQueue :: getQueuedMessages( void ) const
+{
+  OutQueueData *data = static_cast<OutQueueData *> (queueData_);
+  return data->enqueuePos.load( std::memory_order_relaxed ) - data->dequeuePos.load( std::memory_order_relaxed );
+}
+
+unsigned long RtMidiOutQueue :: getRejectedMessages( void ) const
+{
+  OutQueueData *data = static_cast<OutQueueData *> (queueData_);
+  return data->rejected.load( std::memory_order_relaxed );
+}
+
+//*********************************************************************//
+//  RtMidiOut Asynchronous Output Definitions
+//*********************************************************************//
+
+// The transmit thread of an RtMidiOut and what it shares with the
+// sending threads.
+struct OutAsyncData {
+  RtMidiOutQueue *queue;
+  MidiOutApi *api;
+  std::chrono::microseconds pollTime;  // 0 to wait for a wake-up when idle
+  std::thread thread;
+  std::mutex apiMutex;     // held while a call reaches the API
+  std::mutex waitMutex;    // protects wakeRequested, for the conditions below
+  std::condition_variable wake;     // the idle transmit thread waits here
+  std::condition_variable drained;  // flush() waits here
+  bool wakeRequested;
+  std::atomic<bool> idle;
+  std::atomic<bool> stopRequested;
+  std::atomic<unsigned int> flushWaiters;
+  std::atomic<unsigned int> sentPos;  // queue position up to which the messages reached the API
+};
+
+static void wakeTransmitter( OutAsyncData *data )
+{
+  std::lock_guard<std::mutex> lock( data->waitMutex );
+  data->wakeRequested = true;
+  data->wake.notify_one();
+}
+
+void RtMidiOut :: transmitThread( void *asyncData )
+{
+  OutAsyncData *data = static_cast<OutAsyncData *> (asyncData);
+  OutQueueData *queueData = static_cast<OutQueueData *> (data->queue->queueData_);
+
+  for ( ;; ) {
+    unsigned int count = data->queue->drain();
+    if ( count > 0 ) {
+      // The whole batch in one call: one encoding pass and one drain of the API.
+      std::lock_guard<std::mutex> lock( data->apiMutex );
+      try {
+        data->api->sendMessages( &data->queue->batch_ );
+      }
+      catch ( RtMidiError &error ) {
+        error.printMessage();
+      }
+    }
+    data->sentPos.store( queueData->dequeuePos.load( std::memory_order_relaxed ), std::memory_order_release );
+
+    if ( data->flushWaiters.load( std::memory_order_acquire ) > 0 ) {
+      std::lock_guard<std::mutex> lock( data->waitMutex );
+      data->drained.notify_all();
+    }
+    if ( count > 0 ) continue;
+    if ( data->stopRequested.load( std::memory_order_acquire ) ) break;
+
+    if ( data->pollTime.count() > 0 ) {
+      std::this_thread::sleep_for( data->pollTime );
+      continue;
+    }
+
+    // Wait for a sender, unless a message came in since the drain.  The
+    // fences pair with the one in wakeIfIdle(): either the sender sees
+    // idle, or this thread sees the message.
+    std::unique_lock<std::mutex> lock( data->waitMutex );
+    data->idle.store( true, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if ( data->queue->getQueuedMessages() == 0 && !data->stopRequested.load( std::memory_order_relaxed ) )
+      data->wake.wait( lock, [data] { return data->wakeRequested; } );
+    data->wakeRequested = false;
+    data->idle.store( false, std::memory_order_relaxed );
+  }
+}
+
+// Wakes the transmit thread after a push, if it is waiting.
+static inline void wakeIfIdle( OutAsyncData *data )
+{
+  std::atomic_thread_fence( std::memory_order_seq_cst );
+  if ( data->idle.load( std::memory_order_relaxed ) ) wakeTransmitter( data );
+}
+
+// Gives a thread sole use of the API of an RtMidiOut: in asynchronous
+// mode, it waits for the queue to be sent (if \e fence) and keeps the
+// transmit thread out until it goes out of scope.
+class AsyncApiLock {
+ public:
+  AsyncApiLock( RtMidiOut *midiout, void *asyncData, bool fence = true )
+    : data_( static_cast<OutAsyncData *> (asyncData) ) {
+    if ( !data_ ) return;
+    if ( fence ) midiout->flush();
+    data_->apiMutex.lock();
+  }
+  ~AsyncApiLock( void ) { if ( data_ ) data_->apiMutex.unlock(); }
+ private:
+  OutAsyncData *data_;
+};
+
+void RtMidiOut :: setAsync( bool enable, unsigned int capacity, double pollMs )
+{
+  if ( asyncData_ ) {
+    // Send whatever is queued, then stop the transmit thread.
+    OutAsyncData *data = static_cast<OutAsyncData *> (asyncData_);
+    flush();
+    data->stopRequested.store( true, std::memory_order_release );
+    wakeTransmitter( data );
+    data->thread.join();
+    asyncData_ = 0;
+    delete data->queue;
+    delete data;
+  }
+  if ( !enable ) return;
+
+  OutAsyncData *data = new OutAsyncData;
+  data->queue = new RtMidiOutQueue( 0, capacity );
+  data->api = (MidiOutApi *) rtapi_;
+  data->pollTime = std::chrono::microseconds( (long long) ( pollMs * 1000.0 ) );
+  data->wakeRequested = false;
+  data->idle.store( false );
+  data->stopRequested.store( false );
+  data->flushWaiters.store( 0 );
+  data->sentPos.store( 0 );
+  try {
+    data->thread = std::thread( transmitThread, (void *) data );
+  }
+  catch ( std::system_error & ) {
+    delete data->queue;
+    delete data;
+    std::string errorText = "RtMidiOut::setAsync: error creating the transmit thread.";
+    throw( RtMidiError( errorText, RtMidiError::THREAD_ERROR ) );
+  }
+  asyncData_ = (void *) data;
+}
+
+void RtMidiOut :: flush( void )
+{
+  OutAsyncData *data = static_cast<OutAsyncData *> (asyncData_);
+  if ( !data ) return;
+
+  // Every message pushed so far is below this position.
+  OutQueueData *queueData = static_cast<OutQueueData *> (data->queue->queueData_);
+  unsigned int target = queueData->enqueuePos.load( std::memory_order_acquire );
+
+  data->flushWaiters.fetch_add( 1, std::memory_order_acq_rel );
+  wakeTransmitter( data );
+  {
+    std::unique_lock<std::mutex> lock( data->waitMutex );
+    data->drained.wait( lock, [data, target] {
+      return (int) ( data->sentPos.load( std::memory_order_acquire ) - target ) >= 0; } );
+  }
+  data->flushWaiters.fetch_sub( 1, std::memory_order_acq_rel );
+}
+
+unsigned int RtMidiOut :: getQueueDepth( void ) const
+{
+  OutAsyncData *data = static_cast<OutAsyncData *> (asyncData_);
+  return data ? data->queue->getQueuedMessages() : 0;
+}
+
+void RtMidiOut :: sendAsync( const unsigned char *message, size_t size )
+{
+  OutAsyncData *data = static_cast<OutAsyncData *> (asyncData_);
+
+  // What the queue cannot hold goes to the API once the queue is sent.
+  if ( size > RtMidiOutQueue::MAX_MESSAGE_SIZE || !isCompleteMessage( message, size ) ) {
+    AsyncApiLock lock( this, asyncData_ );
+    data->api->sendMessage( message, size );
+    return;
+  }
+
+  while ( !data->queue->push( message, size ) ) {
+    // Full: wait for the transmit thread to make room.
+    wakeIfIdle( data );
+    std::this_thread::yield();
+  }
+  wakeIfIdle( data );
+}
+
+bool RtMidiOut :: trySendAsync( const unsigned char *message, size_t size )
+{
+  OutAsyncData *data = static_cast<OutAsyncData *> (asyncData_);
+
+  if ( size > RtMidiOutQueue::MAX_MESSAGE_SIZE || !isCompleteMessage( message, size ) ) {
+    // Only straight to the API if that does not mean waiting.
+    if ( data->queue->getQueuedMessages() > 0 || !data->apiMutex.try_lock() ) return false;
+    bool sent = data->api->trySend( message, size );
+    data->apiMutex.unlock();
+    return sent;
+  }
+
+  if ( !data->queue->push( message, size ) ) return false;
+  wakeIfIdle( data );
+  return true;
+}
+
+void RtMidiOut :: sendMessages( std::vector<unsigned char> *messages )
+{
+  if ( !asyncData_ ) {
+    ((MidiOutApi *)rtapi_)->sendMessages( messages );
+    return;
+  }
+
+  unsigned int nBytes = messages->size();
+  for ( unsigned int i = 0; i < nBytes; ) {
+    unsigned int length = MidiOutApi::getMessageLength( &(*messages)[i], nBytes - i );
+    sendAsync( &(*messages)[i], length );
+    i += length;
+  }
+}
+
+void RtMidiOut :: openPort( unsigned int portNumber, const std::string portName )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  rtapi_->openPort( portNumber, portName );
+}
+
+void RtMidiOut :: openVirtualPort( const std::string portName )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  rtapi_->openVirtualPort( portName );
+}
+
+void RtMidiOut :: closePort( void )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  rtapi_->closePort();
+}
+
+double RtMidiOut :: getOutputTime( void )
+{
+  AsyncApiLock lock( this, asyncData_, false );
+  return ((MidiOutApi *)rtapi_)->getOutputTime();
+}
+
+void RtMidiOut :: sendMessageAt( double timeStamp, const unsigned char *message, size_t size )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  ((MidiOutApi *)rtapi_)->sendMessageAt( timeStamp, message, size );
+}
+
+void RtMidiOut :: setOutputTempo( unsigned int usPerQuarter, unsigned int ppq )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  ((MidiOutApi *)rtapi_)->setOutputTempo( usPerQuarter, ppq );
+}
+
+void RtMidiOut :: sendMessageAtTick( unsigned long tick, const unsigned char *message, size_t size )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  ((MidiOutApi *)rtapi_)->sendMessageAtTick( tick, message, size );
+}
+
+void RtMidiOut :: setBufferSize( unsigned int bytes )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  ((MidiOutApi *)rtapi_)->setBufferSize( bytes );
+}
+
+void RtMidiOut :: setRunningStatus( bool enable )
+{
+  AsyncApiLock lock( this, asyncData_ );
+  ((MidiOutApi *)rtapi_)->setRunningStatus( enable );
 }
 
 //*********************************************************************//
@@ -355,7 +808,8 @@ double MidiInApi :: getMessage( std::vector<unsigned char> *message )
 //*********************************************************************//
 
 MidiOutApi :: MidiOutApi( void )
-  : MidiApi()
+  : MidiApi(), useRunningStatus_( false ), runningStatus_( 0 ), outputTempo_( 600000 ),
+    outputPpq_( 240 ), scheduleWarned_( false )
 {
 }
 
@@ -363,6 +817,109 @@ MidiOutApi :: ~MidiOutApi( void )
 {
 }
 
+void MidiOutApi :: sendMessage( const unsigned char *message, size_t size )
+{
+  // The API only sends vectors: copy the message into one.
+  groupMessage_.assign( message, message + size );
+  sendMessage( &groupMessage_ );
+}
+
+void MidiOutApi :: sendMessages( std::vector<unsigned char> *messages )
+{
+  // Send the messages one by one.
+  unsigned int nBytes = messages->size();
+  for ( unsigned int i = 0; i < nBytes; ) {
+    unsigned int length = getMessageLength( &(*messages)[i], nBytes - i );
+    sendMessage( &(*messages)[i], length );
+    i += length;
+  }
+}
+
+void MidiOutApi :: sendChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 )
+{
+  // Program change and channel pressure only have 2 bytes.
+  unsigned char message[3] = { status, data1, data2 };
+  sendMessage( message, getMessageLength( message, 3 ) );
+}
+
+bool MidiOutApi :: trySend( const unsigned char *message, size_t size )
+{
+  sendMessage( message, size );
+  return true;
+}
+
+void MidiOutApi :: sendMessageAt( double /*timeStamp*/, const unsigned char *message, size_t size )
+{
+  if ( !scheduleWarned_ ) {
+    scheduleWarned_ = true;
+    errorString_ = "MidiOutApi::sendMessageAt: this API does not schedule output, messages are sent immediately.";
+    error( RtMidiError::WARNING, errorString_ );
+  }
+  sendMessage( message, size );
+}
+
+void MidiOutApi :: setOutputTempo( unsigned int usPerQuarter, unsigned int ppq )
+{
+  if ( usPerQuarter == 0 || ppq == 0 ) {
+    errorString_ = "MidiOutApi::setOutputTempo: the tempo and the resolution must be greater than 0.";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+  outputTempo_ = usPerQuarter;
+  outputPpq_ = ppq;
+}
+
+void MidiOutApi :: sendMessageAtTick( unsigned long tick, const unsigned char *message, size_t size )
+{
+  sendMessageAt( tick * ( outputTempo_ * 0.000001 ) / outputPpq_, message, size );
+}
+
+unsigned int MidiOutApi :: getMessageLength( const unsigned char *message, unsigned int nBytes )
+{
+  if ( nBytes == 0 ) return 0;
+
+  unsigned int length;
+  unsigned char status = message[0];
+  if ( status == 0xF0 ) {
+    // Sysex: up to and including the 0xF7.
+    length = 1;
+    while ( length < nBytes )
+      if ( message[length++] == 0xF7 ) break;
+    return length;
+  }
+  else if ( status < 0x80 ) length = 1;  // stray data byte
+  else if ( status < 0xC0 ) length = 3;  // note off/on, key pressure, control change
+  else if ( status < 0xE0 ) length = 2;  // program change, channel pressure
+  else if ( status < 0xF0 ) length = 3;  // pitch bend
+  else if ( status == 0xF2 ) length = 3; // song position
+  else if ( status == 0xF1 || status == 0xF3 ) length = 2;
+  else length = 1;
+
+  return ( length < nBytes ) ? length : nBytes;
+}
+
+void MidiOutApi :: setRunningStatus( bool enable )
+{
+  useRunningStatus_ = enable;
+  runningStatus_ = 0;
+}
+
+unsigned int MidiOutApi :: encodeRunningStatus( const unsigned char *message, unsigned int nBytes )
+{
+  if ( nBytes == 0 ) return 0;
+  unsigned char status = message[0];
+
+  if ( status < 0x80 ) return 0;  // already running status (or garbage)
+  if ( status >= 0xF0 ) {
+    // A sysex, system common or realtime message interrupts the run.
+    runningStatus_ = 0;
+    return 0;
+  }
+  if ( useRunningStatus_ && status == runningStatus_ && nBytes > 1 ) return 1;
+  runningStatus_ = status;
+  return 0;
+}
+
 // *************************************************** //
 //
 // OS/API-specific methods.
@@ -1101,10 +1658,18 @@ void MidiOutCore :: sendMessage( std::vector<unsigned char> *message )
 
 #include <pthread.h>
 #include <sys/time.h>
+#include <errno.h>
 
 // ALSA header file.
 #include <alsa/asoundlib.h>
 
+// How the output events are sent (see outputEvent()).
+enum AlsaSchedule {
+  SCHEDULE_DIRECT,  // at once
+  SCHEDULE_REAL,    // at eventTime.time on the output queue
+  SCHEDULE_TICK     // at eventTime.tick on the output queue
+};
+
 // A structure to hold variables related to the ALSA API
 // implementation.
 struct AlsaMidiData {
@@ -1118,8 +1683,12 @@ struct AlsaMidiData {
   pthread_t thread;
   pthread_t dummy_thread_id;
   unsigned long long lastTime;
-  int queue_id; // an input queue is needed to get timestamped events
+  int queue_id; // an input queue is needed to get timestamped events (and an output queue to schedule them)
   int trigger_fds[2];
+  AlsaSchedule schedule;
+  snd_seq_timestamp_t eventTime;
+  bool tryOutput;  // a full output pool is not an error (see trySend())
+  bool wouldBlock; // the last event did not fit in the output pool
 };
 
 #define PORT_TYPE( pinfo, bits ) ((snd_seq_port_info_get_capability(pinfo) & (bits)) == (bits))
@@ -1683,6 +2252,7 @@ MidiOutAlsa :: ~MidiOutAlsa()
   if ( data->vport >= 0 ) snd_seq_delete_port( data->seq, data->vport );
   if ( data->coder ) snd_midi_event_free( data->coder );
   if ( data->buffer ) free( data->buffer );
+  if ( data->queue_id >= 0 ) snd_seq_free_queue( data->seq, data->queue_id );
   snd_seq_close( data->seq );
   delete data;
 }
@@ -1709,6 +2279,10 @@ void MidiOutAlsa :: initialize( const std::string& clientName )
   data->bufferSize = 32;
   data->coder = 0;
   data->buffer = 0;
+  data->queue_id = -1;
+  data->schedule = SCHEDULE_DIRECT;
+  data->tryOutput = false;
+  data->wouldBlock = false;
   int result = snd_midi_event_new( data->bufferSize, &data->coder );
   if ( result < 0 ) {
     delete data;
@@ -1716,13 +2290,6 @@ void MidiOutAlsa :: initialize( const std::string& clientName )
     error( RtMidiError::DRIVER_ERROR, errorString_ );
     return;
   }
-  data->buffer = (unsigned char *) malloc( data->bufferSize );
-  if ( data->buffer == NULL ) {
-    delete data;
-    errorString_ = "MidiOutAlsa::initialize: error allocating buffer memory!\n\n";
-    error( RtMidiError::MEMORY_ERROR, errorString_ );
-    return;
-  }
   snd_midi_event_init( data->coder );
   apiData_ = (void *) data;
 }
@@ -1856,47 +2423,234 @@ void MidiOutAlsa :: openVirtualPort( std::string portName )
 
 void MidiOutAlsa :: sendMessage( std::vector<unsigned char> *message )
 {
+  unsigned int nBytes = message->size();
+  sendMessage( nBytes ? &(*message)[0] : NULL, nBytes );
+}
+
+void MidiOutAlsa :: sendMessage( const unsigned char *message, size_t size )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  data->schedule = SCHEDULE_DIRECT;
+  if ( outputMessage( message, (unsigned int) size ) )
+    snd_seq_drain_output(data->seq);
+}
+
+bool MidiOutAlsa :: trySend( const unsigned char *message, size_t size )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+
+  // The sequencer handle is opened in non-blocking mode, so a full pool
+  // returns -EAGAIN.  Events left in the output buffer by an earlier
+  // call go first, to keep the order.
+  if ( snd_seq_event_output_pending(data->seq) > 0 && snd_seq_drain_output(data->seq) < 0 )
+    return false;
+
+  data->schedule = SCHEDULE_DIRECT;
+  data->tryOutput = true;
+  data->wouldBlock = false;
+  bool queued = outputMessage( message, (unsigned int) size );
+  data->tryOutput = false;
+  if ( !queued ) return !data->wouldBlock;
+
+  // If the pool fills up now, the event waits in the output buffer for
+  // the next call.
+  snd_seq_drain_output(data->seq);
+  return true;
+}
+
+void MidiOutAlsa :: sendMessages( std::vector<unsigned char> *messages )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  unsigned int nBytes = messages->size();
+  data->schedule = SCHEDULE_DIRECT;
+  for ( unsigned int i = 0; i < nBytes; ) {
+    // A message that fails is reported and skipped, the rest of the
+    // group (e.g. its NoteOffs) is still sent.
+    unsigned int length = getMessageLength( &(*messages)[i], nBytes - i );
+    outputMessage( &(*messages)[i], length );
+    i += length;
+  }
+
+  // A single system call for the whole group.
+  snd_seq_drain_output(data->seq);
+}
+
+// Sends ev to the subscribers of the output port, at once or on the
+// output queue as set by data->schedule (in the output buffer, until it
+// is drained).
+static int outputEvent( AlsaMidiData *data, snd_seq_event_t *ev )
+{
+  snd_seq_ev_set_source(ev, data->vport);
+  snd_seq_ev_set_subs(ev);
+  if ( data->schedule == SCHEDULE_REAL )
+    snd_seq_ev_schedule_real(ev, data->queue_id, 0, &data->eventTime.time);
+  else if ( data->schedule == SCHEDULE_TICK )
+    snd_seq_ev_schedule_tick(ev, data->queue_id, 0, data->eventTime.tick);
+  else
+    snd_seq_ev_set_direct(ev);
+  int result = snd_seq_event_output(data->seq, ev);
+  data->wouldBlock = ( result == -EAGAIN );
+  return result;
+}
+
+bool MidiOutAlsa :: outputMessage( const unsigned char *message, unsigned int nBytes )
+{
+  // Complete channel messages are filled in directly, without the encoder.
+  if ( nBytes > 0 && message[0] >= 0x80 && message[0] < 0xF0 && nBytes == getMessageLength( message, 3 ) )
+    return outputChannelMessage( message[0], message[1], ( nBytes > 2 ) ? message[2] : 0 );
+
   int result;
   AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
-  unsigned int nBytes = message->size();
   if ( nBytes > data->bufferSize ) {
     data->bufferSize = nBytes;
     result = snd_midi_event_resize_buffer ( data->coder, nBytes);
     if ( result != 0 ) {
       errorString_ = "MidiOutAlsa::sendMessage: ALSA error resizing MIDI event buffer.";
       error( RtMidiError::DRIVER_ERROR, errorString_ );
-      return;
-    }
-    free (data->buffer);
-    data->buffer = (unsigned char *) malloc( data->bufferSize );
-    if ( data->buffer == NULL ) {
-    errorString_ = "MidiOutAlsa::initialize: error allocating buffer memory!\n\n";
-    error( RtMidiError::MEMORY_ERROR, errorString_ );
-    return;
+      return false;
     }
   }
 
   snd_seq_event_t ev;
   snd_seq_ev_clear(&ev);
-  snd_seq_ev_set_source(&ev, data->vport);
-  snd_seq_ev_set_subs(&ev);
-  snd_seq_ev_set_direct(&ev);
-  for ( unsigned int i=0; i<nBytes; ++i ) data->buffer[i] = message->at(i);
-  result = snd_midi_event_encode( data->coder, data->buffer, (long)nBytes, &ev );
+  // The encoder reads the caller's bytes directly.
+  result = snd_midi_event_encode( data->coder, message, (long)nBytes, &ev );
   if ( result < (int)nBytes ) {
     errorString_ = "MidiOutAlsa::sendMessage: event parsing error!";
     error( RtMidiError::WARNING, errorString_ );
-    return;
+    return false;
   }
 
-  // Send the event.
-  result = snd_seq_event_output(data->seq, &ev);
+  // Queue the event in the output buffer.
+  result = outputEvent( data, &ev );
   if ( result < 0 ) {
+    if ( data->wouldBlock && data->tryOutput ) return false;
     errorString_ = "MidiOutAlsa::sendMessage: error sending MIDI message to port.";
     error( RtMidiError::WARNING, errorString_ );
-    return;
+    return false;
   }
-  snd_seq_drain_output(data->seq);
+  return true;
+}
+
+void MidiOutAlsa :: sendChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  data->schedule = SCHEDULE_DIRECT;
+  if ( outputChannelMessage( status, data1, data2 ) )
+    snd_seq_drain_output(data->seq);
+}
+
+bool MidiOutAlsa :: outputChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  unsigned char channel = status & 0x0F;
+
+  snd_seq_event_t ev;
+  snd_seq_ev_clear(&ev);
+  switch ( status & 0xF0 ) {
+  case 0x80: snd_seq_ev_set_noteoff(&ev, channel, data1, data2); break;
+  case 0x90: snd_seq_ev_set_noteon(&ev, channel, data1, data2); break;
+  case 0xA0: snd_seq_ev_set_keypress(&ev, channel, data1, data2); break;
+  case 0xB0: snd_seq_ev_set_controller(&ev, channel, data1, data2); break;
+  case 0xC0: snd_seq_ev_set_pgmchange(&ev, channel, data1); break;
+  case 0xD0: snd_seq_ev_set_chanpress(&ev, channel, data1); break;
+  case 0xE0: snd_seq_ev_set_pitchbend(&ev, channel, ( data1 | ( data2 << 7 ) ) - 8192); break;
+  default:
+    errorString_ = "MidiOutAlsa::sendChannelMessage: not a channel message!";
+    error( RtMidiError::WARNING, errorString_ );
+    return false;
+  }
+
+  // Queue the event in the output buffer.
+  if ( outputEvent( data, &ev ) < 0 ) {
+    if ( data->wouldBlock && data->tryOutput ) return false;
+    errorString_ = "MidiOutAlsa::sendMessage: error sending MIDI message to port.";
+    error( RtMidiError::WARNING, errorString_ );
+    return false;
+  }
+  return true;
+}
+
+// Sets the tempo of the queue, in microseconds per quarter note and ticks per quarter note.
+static int setQueueTempo( AlsaMidiData *data, unsigned int usPerQuarter, unsigned int ppq )
+{
+  snd_seq_queue_tempo_t *qtempo;
+  snd_seq_queue_tempo_alloca(&qtempo);
+  snd_seq_queue_tempo_set_tempo(qtempo, usPerQuarter);
+  snd_seq_queue_tempo_set_ppq(qtempo, ppq);
+  return snd_seq_set_queue_tempo(data->seq, data->queue_id, qtempo);
+}
+
+bool MidiOutAlsa :: startOutputQueue( void )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  if ( data->queue_id >= 0 ) return true;
+
+  // The output clock starts now.
+  data->queue_id = snd_seq_alloc_named_queue( data->seq, "RtMidi Output Queue" );
+  if ( data->queue_id < 0 ) {
+    errorString_ = "MidiOutAlsa::startOutputQueue: error allocating the output queue.";
+    error( RtMidiError::DRIVER_ERROR, errorString_ );
+    return false;
+  }
+  setQueueTempo( data, outputTempo_, outputPpq_ );
+  snd_seq_start_queue( data->seq, data->queue_id, NULL );
+  snd_seq_drain_output( data->seq );
+  return true;
+}
+
+double MidiOutAlsa :: getOutputTime( void )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  if ( !startOutputQueue() ) return 0.0;
+
+  snd_seq_queue_status_t *status;
+  snd_seq_queue_status_alloca( &status );
+  if ( snd_seq_get_queue_status( data->seq, data->queue_id, status ) < 0 ) {
+    errorString_ = "MidiOutAlsa::getOutputTime: error reading the output queue status.";
+    error( RtMidiError::WARNING, errorString_ );
+    return 0.0;
+  }
+  const snd_seq_real_time_t *time = snd_seq_queue_status_get_real_time( status );
+  return time->tv_sec + time->tv_nsec * 0.000000001;
+}
+
+void MidiOutAlsa :: sendMessageAt( double timeStamp, const unsigned char *message, size_t size )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  if ( !startOutputQueue() ) return;
+
+  if ( timeStamp < 0.0 ) timeStamp = 0.0;
+  data->schedule = SCHEDULE_REAL;
+  data->eventTime.time.tv_sec = (unsigned int) timeStamp;
+  data->eventTime.time.tv_nsec = (unsigned int) ( ( timeStamp - data->eventTime.time.tv_sec ) * 1000000000.0 );
+  bool queued = outputMessage( message, (unsigned int) size );
+  data->schedule = SCHEDULE_DIRECT;
+  if ( queued ) snd_seq_drain_output(data->seq);
+}
+
+void MidiOutAlsa :: setOutputTempo( unsigned int usPerQuarter, unsigned int ppq )
+{
+  MidiOutApi::setOutputTempo( usPerQuarter, ppq );
+
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  if ( data->queue_id < 0 ) return;
+  if ( setQueueTempo( data, outputTempo_, outputPpq_ ) < 0 ) {
+    errorString_ = "MidiOutAlsa::setOutputTempo: error setting the output queue tempo (the resolution cannot change once the clock runs).";
+    error( RtMidiError::WARNING, errorString_ );
+  }
+}
+
+void MidiOutAlsa :: sendMessageAtTick( unsigned long tick, const unsigned char *message, size_t size )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  if ( !startOutputQueue() ) return;
+
+  data->schedule = SCHEDULE_TICK;
+  data->eventTime.tick = (snd_seq_tick_time_t) tick;
+  bool queued = outputMessage( message, (unsigned int) size );
+  data->schedule = SCHEDULE_DIRECT;
+  if ( queued ) snd_seq_drain_output(data->seq);
 }
 
 #endif // __LINUX_ALSA__
@@ -2324,6 +3078,7 @@ void MidiOutWinMM :: openPort( unsigned int portNumber, const std::string /*port
   }
 
   connected_ = true;
+  runningStatus_ = 0;
 }
 
 void MidiOutWinMM :: closePort( void )
@@ -2358,6 +3113,9 @@ void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
   WinMidiData *data = static_cast<WinMidiData *> (apiData_);
   if ( message->at(0) == 0xF0 ) { // Sysex message
 
+    // A sysex interrupts the running status.
+    encodeRunningStatus( &message->at(0), nBytes );
+
     // Allocate buffer for sysex data.
     char *buffer = (char *) malloc( nBytes );
     if ( buffer == NULL ) {
@@ -2404,10 +3162,11 @@ void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
       return;
     }
 
-    // Pack MIDI bytes into double word.
-    DWORD packet;
+    // Pack MIDI bytes into double word.  With running status, a
+    // repeated status byte is left out and the data bytes come first.
+    DWORD packet = 0;
     unsigned char *ptr = (unsigned char *) &packet;
-    for ( unsigned int i=0; i<nBytes; ++i ) {
+    for ( unsigned int i=encodeRunningStatus( &message->at(0), nBytes ); i<nBytes; ++i ) {
       *ptr = message->at(i);
       ++ptr;
     }
@@ -2415,6 +3174,7 @@ void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
     // Send the message immediately.
     result = midiOutShortMsg( data->outHandle, packet );
     if ( result != MMSYSERR_NOERROR ) {
+      runningStatus_ = 0;
       errorString_ = "MidiOutWinMM::sendMessage: error sending MIDI message.";
       error( RtMidiError::DRIVER_ERROR, errorString_ );
     }
@@ -2438,18 +3198,29 @@ void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
 #include <jack/jack.h>
 #include <jack/midiport.h>
 #include <jack/ringbuffer.h>
+#include <cstring>
 
 #define JACK_RINGBUFFER_SIZE 16384 // Default size for ringbuffer
 
 struct JackMidiData {
   jack_client_t *client;
   jack_port_t *port;
-  jack_ringbuffer_t *buffSize;
-  jack_ringbuffer_t *buffMessage;
+  jack_ringbuffer_t *buffMessage; // output records: a JackMessageHeader, then the bytes
+  unsigned int bufferSize;        // size asked for buffMessage
+  unsigned int bufferCapacity;    // bytes buffMessage can actually hold
+  unsigned int highWater;         // most bytes buffMessage has held
+  unsigned long dropped;          // messages that did not fit in buffMessage
   jack_time_t lastTime;
+  jack_time_t timeOrigin; // output clock origin (0 until the clock starts)
   MidiInApi :: RtMidiInData *rtMidiIn;
   };
 
+// Header of each output record in buffMessage.
+struct JackMessageHeader {
+  jack_time_t time;  // due time on the JACK clock, in microseconds (0 = now)
+  int size;
+  };
+
 //*********************************************************************//
 //  API: JACK
 //  Class Definitions: MidiInJack
@@ -2659,7 +3430,7 @@ static int jackProcessOut( jack_nframes_t nframes, void *arg )
 {
   JackMidiData *data = (JackMidiData *) arg;
   jack_midi_data_t *midiData;
-  int space;
+  JackMessageHeader header;
 
   // Is port created?
   if ( data->port == NULL ) return 0;
@@ -2667,16 +3438,58 @@ static int jackProcessOut( jack_nframes_t nframes, void *arg )
   void *buff = jack_port_get_buffer( data->port, nframes );
   jack_midi_clear_buffer( buff );
 
-  while ( jack_ringbuffer_read_space( data->buffSize ) > 0 ) {
-    jack_ringbuffer_read( data->buffSize, (char *) &space, (size_t) sizeof(space) );
-    midiData = jack_midi_event_reserve( buff, 0, space );
+  // Place each message at the frame of its due time within this cycle.
+  // Messages leave in order: the first one due in a later cycle holds
+  // back the rest, and a late message goes out at the current offset.
+  jack_nframes_t cycleStart = jack_last_frame_time( data->client );
+  jack_nframes_t offset = 0;
+  while ( jack_ringbuffer_read_space( data->buffMessage ) >= sizeof(header) ) {
+    // Records are committed whole, so the bytes follow the header.
+    jack_ringbuffer_peek( data->buffMessage, (char *) &header, sizeof(header) );
+    if ( header.time ) {
+      int frames = (int) ( jack_time_to_frames( data->client, header.time ) - cycleStart );
+      if ( frames >= (int) nframes ) break;
+      if ( frames > (int) offset ) offset = frames;
+    }
+
+    midiData = jack_midi_event_reserve( buff, offset, header.size );
+    if ( midiData == NULL && jack_midi_get_event_count( buff ) > 0 )
+      break;  // the port buffer is full, send the rest next cycle
 
-    jack_ringbuffer_read( data->buffMessage, (char *) midiData, (size_t) space );
+    jack_ringbuffer_read_advance( data->buffMessage, sizeof(header) );
+    if ( midiData )
+      jack_ringbuffer_read( data->buffMessage, (char *) midiData, (size_t) header.size );
+    else  // larger than an empty port buffer: drop it
+      jack_ringbuffer_read_advance( data->buffMessage, (size_t) header.size );
   }
 
   return 0;
 }
 
+// Copies \e nBytes of \e source at \e offset of the two-part write vector of a ringbuffer.
+static void jackCopyToVector( jack_ringbuffer_data_t *vector, size_t offset, const char *source, size_t nBytes )
+{
+  if ( offset < vector[0].len ) {
+    size_t first = vector[0].len - offset;
+    if ( first > nBytes ) first = nBytes;
+    memcpy( vector[0].buf + offset, source, first );
+    source += first;
+    nBytes -= first;
+    offset = 0;
+  }
+  else offset -= vector[0].len;
+  if ( nBytes ) memcpy( vector[1].buf + offset, source, nBytes );
+}
+
+// Creates the output ring of \e data, with its counters cleared.
+static void jackCreateBuffer( JackMidiData *data )
+{
+  data->buffMessage = jack_ringbuffer_create( data->bufferSize );
+  data->bufferCapacity = jack_ringbuffer_write_space( data->buffMessage );
+  data->highWater = 0;
+  data->dropped = 0;
+}
+
 MidiOutJack :: MidiOutJack( const std::string clientName ) : MidiOutApi()
 {
   initialize( clientName );
@@ -2689,7 +3502,14 @@ void MidiOutJack :: initialize( const std::string& clientName )
 
   data->port = NULL;
   data->client = NULL;
+  data->buffMessage = NULL;
+  data->bufferSize = JACK_RINGBUFFER_SIZE;
+  data->bufferCapacity = 0;
+  data->highWater = 0;
+  data->dropped = 0;
+  data->timeOrigin = 0;
   this->clientName = clientName;
+  dropWarned_ = false;
 
   connect();
 }
@@ -2708,8 +3528,7 @@ void MidiOutJack :: connect()
   }
 
   jack_set_process_callback( data->client, jackProcessOut, data );
-  data->buffSize = jack_ringbuffer_create( JACK_RINGBUFFER_SIZE );
-  data->buffMessage = jack_ringbuffer_create( JACK_RINGBUFFER_SIZE );
+  jackCreateBuffer( data );
   jack_activate( data->client );
 }
 
@@ -2721,7 +3540,6 @@ MidiOutJack :: ~MidiOutJack()
   if ( data->client ) {
     // Cleanup
     jack_client_close( data->client );
-    jack_ringbuffer_free( data->buffSize );
     jack_ringbuffer_free( data->buffMessage );
   }
 
@@ -2827,13 +3645,145 @@ void MidiOutJack :: closePort()
 
 void MidiOutJack :: sendMessage( std::vector<unsigned char> *message )
 {
-  int nBytes = message->size();
-  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  unsigned int nBytes = message->size();
+  sendMessage( nBytes ? &(*message)[0] : NULL, nBytes );
+}
 
+void MidiOutJack :: sendMessage( const unsigned char *message, size_t size )
+{
   // Write full message to buffer
-  jack_ringbuffer_write( data->buffMessage, ( const char * ) &( *message )[0],
-                         message->size() );
-  jack_ringbuffer_write( data->buffSize, ( char * ) &nBytes, sizeof( nBytes ) );
+  queueMessage( message, size, 0 );
+}
+
+void MidiOutJack :: sendMessages( std::vector<unsigned char> *messages )
+{
+  unsigned int nBytes = messages->size();
+
+  // Write each message of the group straight from the caller's buffer.
+  for ( unsigned int i = 0; i < nBytes; ) {
+    int length = getMessageLength( &(*messages)[i], nBytes - i );
+    queueMessage( &(*messages)[i], length, 0 );
+    i += length;
+  }
+}
+
+bool MidiOutJack :: trySend( const unsigned char *message, size_t size )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  if ( data->buffMessage == NULL ) {
+    errorString_ = "MidiOutJack::trySend: no JACK client, message not sent.";
+    error( RtMidiError::WARNING, errorString_ );
+    return false;
+  }
+
+  // Wait for the process callback to make room, unless the message
+  // could never fit (queueMessage() drops it then).
+  size_t recordSize = sizeof(JackMessageHeader) + size;
+  if ( recordSize <= data->bufferCapacity &&
+       jack_ringbuffer_write_space( data->buffMessage ) < recordSize )
+    return false;
+
+  queueMessage( message, size, 0 );
+  return true;
+}
+
+double MidiOutJack :: getOutputTime( void )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  if ( !data->client ) return 0.0;
+
+  // The output clock is the JACK clock, from the first call on.
+  jack_time_t now = jack_get_time();
+  if ( data->timeOrigin == 0 ) data->timeOrigin = now;
+  return ( now - data->timeOrigin ) * 0.000001;
+}
+
+void MidiOutJack :: sendMessageAt( double timeStamp, const unsigned char *message, size_t size )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  if ( !data->client ) return;
+
+  if ( data->timeOrigin == 0 ) data->timeOrigin = jack_get_time();
+  if ( timeStamp < 0.0 ) timeStamp = 0.0;
+  queueMessage( message, size, data->timeOrigin + (jack_time_t) ( timeStamp * 1000000.0 + 0.5 ) );
+}
+
+bool MidiOutJack :: queueMessage( const unsigned char *message, int nBytes, unsigned long long time )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  if ( data->buffMessage == NULL ) {
+    errorString_ = "MidiOutJack::sendMessage: no JACK client, message not sent.";
+    error( RtMidiError::WARNING, errorString_ );
+    return false;
+  }
+
+  JackMessageHeader header;
+  header.time = time;
+  header.size = nBytes;
+
+  // Commit the header and the bytes with a single write advance, so the
+  // process callback sees the whole record or nothing of it.
+  size_t recordSize = sizeof(header) + nBytes;
+  size_t space = jack_ringbuffer_write_space( data->buffMessage );
+  if ( space < recordSize ) {
+    data->dropped++;
+    if ( !dropWarned_ ) {
+      dropWarned_ = true;
+      errorString_ = "MidiOutJack::sendMessage: the output buffer is full, message dropped (see RtMidiOut::setBufferSize()).";
+      error( RtMidiError::WARNING, errorString_ );
+    }
+    return false;
+  }
+
+  jack_ringbuffer_data_t vector[2];
+  jack_ringbuffer_get_write_vector( data->buffMessage, vector );
+  jackCopyToVector( vector, 0, (const char *) &header, sizeof(header) );
+  jackCopyToVector( vector, sizeof(header), (const char *) message, nBytes );
+  jack_ringbuffer_write_advance( data->buffMessage, recordSize );
+
+  unsigned int used = data->bufferCapacity - ( space - recordSize );
+  if ( used > data->highWater ) data->highWater = used;
+  return true;
+}
+
+void MidiOutJack :: setBufferSize( unsigned int bytes )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  if ( data->port != NULL ) {
+    errorString_ = "MidiOutJack::setBufferSize: the output buffer cannot be resized while a port is open.";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+  if ( bytes <= sizeof(JackMessageHeader) ) {
+    errorString_ = "MidiOutJack::setBufferSize: the output buffer is too small to hold a message.";
+    error( RtMidiError::WARNING, errorString_ );
+    return;
+  }
+
+  // No port, so the process callback does not touch the ring.
+  data->bufferSize = bytes;
+  dropWarned_ = false;
+  if ( data->buffMessage == NULL ) return;
+  jack_ringbuffer_free( data->buffMessage );
+  jackCreateBuffer( data );
+}
+
+unsigned int MidiOutJack :: getBufferSize( void )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  return data->buffMessage ? data->bufferCapacity : 0;
+}
+
+unsigned long MidiOutJack :: getDroppedMessages( void )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  return data->dropped;
+}
+
+unsigned int MidiOutJack :: getBufferHighWater( void )
+{
+  JackMidiData *data = static_cast<JackMidiData *> (apiData_);
+  return data->highWater;
 }
 
 #endif  // __UNIX_JACK__
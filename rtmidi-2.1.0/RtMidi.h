@@ -408,6 +408,196 @@ class RtMidiOut : public RtMidi
   */
   void sendMessage( std::vector<unsigned char> *message );
 
+  //! Immediately send the single message of \e size bytes at \e message out an open MIDI output port.
+  /*!
+      The message can be in any memory (e.g. an array on the stack or
+      part of a larger buffer).  The ALSA, JACK and dummy APIs send it
+      from there without allocating or copying it first.  An exception
+      is thrown if an error occurs during output or an output
+      connection was not previously established.
+  */
+  void sendMessage( const unsigned char *message, size_t size );
+
+  //! Send the single message of \e size bytes at \e message, unless the output would block.
+  /*!
+      Returns false, without sending anything, if the message cannot be
+      handed to the API at once: the ALSA sequencer pool or the JACK
+      output buffer is full.  The caller can then drop the message,
+      coalesce it with a later one or retry, and the message does not
+      count as dropped by the output buffer (see getDroppedMessages()).
+      Other errors are reported as with sendMessage(), and the message
+      does not need to be sent again, except that false is also returned,
+      with a warning, when JACK has no client to send through.  The APIs
+      that hand the message straight to the driver (CoreMIDI, Windows MM)
+      always send it and return true.
+  */
+  bool trySend( const unsigned char *message, size_t size );
+
+  //! Send the single message in \e message, unless the output would block (see above).
+  bool trySend( std::vector<unsigned char> *message );
+
+  //! Immediately send a Note On message on \e channel (0 to 15).
+  /*!
+      The typed sends give the message fields directly: the ALSA API
+      fills the sequencer event without going through its MIDI byte
+      parser, and the other APIs write the 2 or 3 bytes of the message
+      as they are.  The data bytes are masked to 7 bits.  An exception
+      is thrown if an error occurs during output or an output
+      connection was not previously established.
+  */
+  void sendNoteOn( unsigned char channel, unsigned char note, unsigned char velocity );
+
+  //! Immediately send a Note Off message on \e channel (0 to 15).
+  void sendNoteOff( unsigned char channel, unsigned char note, unsigned char velocity = 0 );
+
+  //! Immediately send a Control Change message on \e channel (0 to 15).
+  void sendControlChange( unsigned char channel, unsigned char controller, unsigned char value );
+
+  //! Immediately send a Program Change message on \e channel (0 to 15).
+  void sendProgramChange( unsigned char channel, unsigned char program );
+
+  //! Immediately send a Pitch Bend message on \e channel (0 to 15), \e value going from 0 to 16383 (8192 is the center).
+  void sendPitchBend( unsigned char channel, unsigned short value );
+
+  //! Immediately send a group of messages that share the same time out an open MIDI output port.
+  /*!
+      The complete messages of the group (e.g. the notes of a chord)
+      are stored back to back in \e messages.  With the ALSA API, the
+      whole group is encoded into the output buffer and drained with a
+      single system call.  The other APIs send the messages one after
+      the other.  A message that cannot be sent is reported and skipped,
+      and the rest of the group is still sent.  An exception is thrown
+      if an error occurs during output or an output connection was not
+      previously established.
+  */
+  void sendMessages( std::vector<unsigned char> *messages );
+
+  //! Returns the time of the output clock, in seconds.
+  /*!
+      With the ALSA API, the output clock is a sequencer queue started
+      at 0 by the first call to getOutputTime(), sendMessageAt() or
+      sendMessageAtTick().  With the JACK API, it is the JACK clock,
+      also counted from the first of these calls.  It is always 0.0 with
+      the APIs that do not schedule output.
+  */
+  double getOutputTime( void );
+
+  //! Schedule a single message at \e timeStamp seconds of the output clock.
+  /*!
+      With the ALSA API, the message is queued in the kernel sequencer,
+      which dispatches it on time whatever this process is doing, so a
+      whole measure can be sent ahead of time.  A message whose time has
+      already passed is dispatched at once.  With the JACK API, the
+      message is placed at the frame of its time within the JACK cycle,
+      so its timing does not depend on the buffer size; messages leave
+      in the order they were sent, so one sent without a time stamp
+      waits behind the scheduled ones.  The APIs that do not
+      schedule output send the message immediately (with a warning the
+      first time).  An exception is thrown if an error occurs during
+      output or an output connection was not previously established.
+  */
+  void sendMessageAt( double timeStamp, const unsigned char *message, size_t size );
+
+  //! Schedule a single message at \e timeStamp seconds of the output clock (see above).
+  void sendMessageAt( double timeStamp, std::vector<unsigned char> *message );
+
+  //! Set the tempo of the ticks of sendMessageAtTick().
+  /*!
+      The default tempo is 600000 microseconds per quarter note, with
+      240 ticks per quarter note.  With the ALSA API, the resolution
+      can only be changed before the output clock starts.
+  */
+  void setOutputTempo( unsigned int usPerQuarter, unsigned int ppq );
+
+  //! Schedule a single message at \e tick of the output clock.
+  /*!
+      The ALSA API schedules the message on the ticks of its queue.  The
+      other APIs convert \e tick to seconds with the current tempo.
+  */
+  void sendMessageAtTick( unsigned long tick, const unsigned char *message, size_t size );
+
+  //! Set the size of the output buffer, in bytes.
+  /*!
+      With the JACK API, the messages wait in a lock-free ring for the
+      next process cycle, each one stored as a record of its bytes plus
+      a 16-byte header.  A message that does not fit in the free space
+      is dropped whole (see getDroppedMessages()).  The default size is
+      16384 bytes, rounded up to a power of two.  The size can only be
+      changed while no port is open, and it also resets the counters.
+      The other APIs do not buffer output and ignore this setting.
+  */
+  void setBufferSize( unsigned int bytes );
+
+  //! Returns the number of bytes the output buffer can hold (0 if the API does not buffer output).
+  unsigned int getBufferSize( void );
+
+  //! Returns the number of messages dropped because the output buffer was full.
+  unsigned long getDroppedMessages( void );
+
+  //! Returns the most bytes the output buffer has held at once.
+  /*!
+      Compared with getBufferSize(), this tells how close a burst of
+      messages came to overflowing the buffer.
+  */
+  unsigned int getBufferHighWater( void );
+
+  //! Enable or disable running status on the output (disabled by default).
+  /*!
+      With running status, the status byte of a channel message is
+      dropped when it repeats the status of the previous channel
+      message, which cuts the wire time of a run of messages of the
+      same type and channel (e.g. NoteOns) by about a third on a MIDI
+      cable.  The status is sent again after any system message
+      (sysex, system common or realtime) and after the port is opened.
+      This only applies to APIs that hand a byte stream to the driver
+      (currently Windows MM); the other APIs always deliver complete
+      messages and ignore this setting.
+  */
+  void setRunningStatus( bool enable );
+
+  //! Returns true if running status is enabled.
+  bool getRunningStatus( void ) const;
+
+  //! Enable or disable the asynchronous output mode (disabled by default).
+  /*!
+      In asynchronous mode, sendMessage(), sendMessages(), trySend()
+      and the typed sends (sendNoteOn(), ...) only queue the messages in
+      a preallocated RtMidiOutQueue of at least \e capacity messages,
+      from any number of threads, and a transmit thread owned by this
+      object hands them to the API in groups.  The caller no longer pays
+      for the encoding or the system calls of the API: a send costs a
+      compare-and-swap, plus a wake-up call when the transmit thread was
+      idle.  With \e pollMs > 0, the transmit thread is never idle and
+      checks the queue every \e pollMs milliseconds instead, so a send
+      never makes a system call, at the cost of up to \e pollMs of
+      latency.
+
+      When the queue is full, sendMessage() waits for room and trySend()
+      returns false.  A message longer than
+      RtMidiOutQueue::MAX_MESSAGE_SIZE, the scheduled sends
+      (sendMessageAt()) and the port and settings calls wait for the
+      queue to be sent (see flush()) and then go straight to the API.
+      Errors of the API during the transmission are printed rather
+      than thrown.  Disabling the mode, or destroying the object, sends
+      whatever is still queued first.
+  */
+  void setAsync( bool enable, unsigned int capacity = 1024, double pollMs = 0.0 );
+
+  //! Returns true if the asynchronous output mode is enabled.
+  bool isAsync( void ) const { return asyncData_ != 0; }
+
+  //! Wait until every message sent so far has been handed to the API.
+  /*!
+      This is a fence for the asynchronous output mode: the messages
+      sent by this thread before the call have reached the API when it
+      returns (the JACK API may still hold them until its next cycle).
+      It returns at once when the mode is disabled.
+  */
+  void flush( void );
+
+  //! Returns the number of messages waiting for the transmit thread (0 if the mode is disabled).
+  unsigned int getQueueDepth( void ) const;
+
   //! Set an error callback function to be invoked when an error has occured.
   /*!
     The callback function will be called whenever an error has occured. It is best
@@ -417,9 +607,92 @@ class RtMidiOut : public RtMidi
 
  protected:
   void openMidiApi( RtMidi::Api api, const std::string clientName );
+
+  // Sends a channel message through the queue or straight to the API.
+  void sendChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 );
+
+  // The asynchronous sends (see setAsync()).
+  void sendAsync( const unsigned char *message, size_t size );
+  bool trySendAsync( const unsigned char *message, size_t size );
+  static void transmitThread( void *asyncData );
+
+  void *asyncData_;  // 0 unless the asynchronous output mode is enabled
 };
 
 
+/**********************************************************************/
+/*! \class RtMidiOutQueue
+    \brief A lock-free queue for feeding one RtMidiOut from several threads.
+
+    RtMidiOut is not thread-safe: only one thread at a time may send
+    through it.  An RtMidiOutQueue lets any number of producer threads
+    push() messages without locks, while a single thread calls drain()
+    to hand everything queued so far to the port, as one group (see
+    RtMidiOut::sendMessages()).
+
+    The queue is a ring of 64-byte slots, each holding one complete
+    message of up to MAX_MESSAGE_SIZE bytes.  A producer claims a slot
+    with a single compare-and-swap, which it only retries when another
+    producer claimed the same slot first, so a push never waits for the
+    drain or for a stalled producer, whatever the number of threads.
+    Messages leave in the order their slots were claimed.
+*/
+/**********************************************************************/
+
+class RtMidiOutQueue
+{
+ public:
+
+  //! The most bytes in one queued message.
+  static const unsigned int MAX_MESSAGE_SIZE = 59;
+
+  //! The constructor, for a queue of at least \e capacity messages in front of \e midiout.
+  /*!
+    The capacity is rounded up to a power of two.  With \e midiout = 0,
+    drain() only discards the messages (e.g. to measure the producers).
+  */
+  RtMidiOutQueue( RtMidiOut *midiout, unsigned int capacity = 1024 );
+
+  //! The destructor drops the messages still queued.
+  ~RtMidiOutQueue( void );
+
+  //! Queue the single message of \e size bytes at \e message, from any thread.
+  /*!
+    Returns false, without queueing anything, if the queue is full or
+    the message is not one complete message of 1 to MAX_MESSAGE_SIZE
+    bytes (see getRejectedMessages()).
+  */
+  bool push( const unsigned char *message, size_t size );
+
+  //! Queue the single message in \e message, from any thread (see above).
+  bool push( std::vector<unsigned char> *message );
+
+  //! Send the queued messages to the port as one group, and return how many were sent.
+  /*!
+    At most \e maxMessages are sent (0 for all of them).  Only one
+    thread may call drain() at a time, and no other thread may use the
+    RtMidiOut meanwhile.  An exception is thrown if an error occurs
+    during output.
+  */
+  unsigned int drain( unsigned int maxMessages = 0 );
+
+  //! Returns the number of messages the queue can hold.
+  unsigned int getCapacity( void ) const;
+
+  //! Returns the number of messages queued and not yet drained (approximate while threads push).
+  unsigned int getQueuedMessages( void ) const;
+
+  //! Returns the number of messages push() refused.
+  unsigned long getRejectedMessages( void ) const;
+
+ protected:
+  RtMidiOut *midiout_;
+  void *queueData_;
+  std::vector<unsigned char> batch_;  // the messages of a drain, sent as one group
+
+  friend class RtMidiOut;  // its transmit thread sends the batches itself
+};
+
 // **************************************************************** //
 //
 // MidiInApi / MidiOutApi class declarations.
@@ -528,6 +801,36 @@ class MidiOutApi : public MidiApi
   MidiOutApi( void );
   virtual ~MidiOutApi( void );
   virtual void sendMessage( std::vector<unsigned char> *message ) = 0;
+  virtual void sendMessage( const unsigned char *message, size_t size );
+  virtual void sendMessages( std::vector<unsigned char> *messages );
+  virtual bool trySend( const unsigned char *message, size_t size );
+  virtual void sendChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 );
+  virtual double getOutputTime( void ) { return 0.0; }
+  virtual void sendMessageAt( double timeStamp, const unsigned char *message, size_t size );
+  virtual void setOutputTempo( unsigned int usPerQuarter, unsigned int ppq );
+  virtual void sendMessageAtTick( unsigned long tick, const unsigned char *message, size_t size );
+  virtual void setBufferSize( unsigned int /*bytes*/ ) {}
+  virtual unsigned int getBufferSize( void ) { return 0; }
+  virtual unsigned long getDroppedMessages( void ) { return 0; }
+  virtual unsigned int getBufferHighWater( void ) { return 0; }
+  void setRunningStatus( bool enable );
+
+  //! Returns the length of the complete message starting at \e message (at most \e nBytes).
+  static unsigned int getMessageLength( const unsigned char *message, unsigned int nBytes );
+  bool getRunningStatus( void ) const { return useRunningStatus_; }
+
+ protected:
+  // Returns the number of leading bytes of the message (0 or 1) that
+  // running status allows to drop, and updates the running status.
+  // Subclasses that write a byte stream call it for each message.
+  unsigned int encodeRunningStatus( const unsigned char *message, unsigned int nBytes );
+
+  bool useRunningStatus_;
+  unsigned char runningStatus_;  // 0 when the next status must be sent
+  std::vector<unsigned char> groupMessage_;  // a copy of the message, for the default sendMessage()
+  unsigned int outputTempo_;  // microseconds per quarter note
+  unsigned int outputPpq_;
+  bool scheduleWarned_;
 };
 
 // **************************************************************** //
@@ -550,13 +853,31 @@ inline double RtMidiIn :: getMessage( std::vector<unsigned char> *message ) { re
 inline void RtMidiIn :: setErrorCallback( RtMidiErrorCallback errorCallback ) { rtapi_->setErrorCallback(errorCallback); }
 
 inline RtMidi::Api RtMidiOut :: getCurrentApi( void ) throw() { return rtapi_->getCurrentApi(); }
-inline void RtMidiOut :: openPort( unsigned int portNumber, const std::string portName ) { rtapi_->openPort( portNumber, portName ); }
-inline void RtMidiOut :: openVirtualPort( const std::string portName ) { rtapi_->openVirtualPort( portName ); }
-inline void RtMidiOut :: closePort( void ) { rtapi_->closePort(); }
 inline bool RtMidiOut :: isPortOpen() const { return rtapi_->isPortOpen(); }
 inline unsigned int RtMidiOut :: getPortCount( void ) { return rtapi_->getPortCount(); }
 inline std::string RtMidiOut :: getPortName( unsigned int portNumber ) { return rtapi_->getPortName( portNumber ); }
-inline void RtMidiOut :: sendMessage( std::vector<unsigned char> *message ) { ((MidiOutApi *)rtapi_)->sendMessage( message ); }
+inline void RtMidiOut :: sendMessage( std::vector<unsigned char> *message ) { if ( asyncData_ ) sendAsync( message->empty() ? NULL : &(*message)[0], message->size() ); else ((MidiOutApi *)rtapi_)->sendMessage( message ); }
+inline void RtMidiOut :: sendMessage( const unsigned char *message, size_t size ) { if ( asyncData_ ) sendAsync( message, size ); else ((MidiOutApi *)rtapi_)->sendMessage( message, size ); }
+inline bool RtMidiOut :: trySend( const unsigned char *message, size_t size ) { return asyncData_ ? trySendAsync( message, size ) : ((MidiOutApi *)rtapi_)->trySend( message, size ); }
+inline bool RtMidiOut :: trySend( std::vector<unsigned char> *message ) { return trySend( message->empty() ? NULL : &(*message)[0], message->size() ); }
+inline void RtMidiOut :: sendChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 )
+{
+  if ( asyncData_ ) {
+    unsigned char message[3] = { status, data1, data2 };
+    sendAsync( message, MidiOutApi::getMessageLength( message, 3 ) );
+  }
+  else ((MidiOutApi *)rtapi_)->sendChannelMessage( status, data1, data2 );
+}
+inline void RtMidiOut :: sendNoteOn( unsigned char channel, unsigned char note, unsigned char velocity ) { sendChannelMessage( 0x90 | ( channel & 0x0F ), note & 0x7F, velocity & 0x7F ); }
+inline void RtMidiOut :: sendNoteOff( unsigned char channel, unsigned char note, unsigned char velocity ) { sendChannelMessage( 0x80 | ( channel & 0x0F ), note & 0x7F, velocity & 0x7F ); }
+inline void RtMidiOut :: sendControlChange( unsigned char channel, unsigned char controller, unsigned char value ) { sendChannelMessage( 0xB0 | ( channel & 0x0F ), controller & 0x7F, value & 0x7F ); }
+inline void RtMidiOut :: sendProgramChange( unsigned char channel, unsigned char program ) { sendChannelMessage( 0xC0 | ( channel & 0x0F ), program & 0x7F, 0 ); }
+inline void RtMidiOut :: sendPitchBend( unsigned char channel, unsigned short value ) { sendChannelMessage( 0xE0 | ( channel & 0x0F ), value & 0x7F, ( value >> 7 ) & 0x7F ); }
+inline void RtMidiOut :: sendMessageAt( double timeStamp, std::vector<unsigned char> *message ) { sendMessageAt( timeStamp, message->empty() ? NULL : &(*message)[0], message->size() ); }
+inline unsigned int RtMidiOut :: getBufferSize( void ) { return ((MidiOutApi *)rtapi_)->getBufferSize(); }
+inline unsigned long RtMidiOut :: getDroppedMessages( void ) { return ((MidiOutApi *)rtapi_)->getDroppedMessages(); }
+inline unsigned int RtMidiOut :: getBufferHighWater( void ) { return ((MidiOutApi *)rtapi_)->getBufferHighWater(); }
+inline bool RtMidiOut :: getRunningStatus( void ) const { return ((MidiOutApi *)rtapi_)->getRunningStatus(); }
 inline void RtMidiOut :: setErrorCallback( RtMidiErrorCallback errorCallback ) { rtapi_->setErrorCallback(errorCallback); }
 
 // **************************************************************** //
@@ -599,6 +920,7 @@ class MidiOutCore: public MidiOutApi
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
   void sendMessage( std::vector<unsigned char> *message );
+  using MidiOutApi::sendMessage;  // copies into a vector
 
  protected:
   void initialize( const std::string& clientName );
@@ -639,10 +961,21 @@ class MidiOutJack: public MidiOutApi
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
   void sendMessage( std::vector<unsigned char> *message );
+  void sendMessage( const unsigned char *message, size_t size );
+  void sendMessages( std::vector<unsigned char> *messages );
+  bool trySend( const unsigned char *message, size_t size );
+  double getOutputTime( void );
+  void sendMessageAt( double timeStamp, const unsigned char *message, size_t size );
+  void setBufferSize( unsigned int bytes );
+  unsigned int getBufferSize( void );
+  unsigned long getDroppedMessages( void );
+  unsigned int getBufferHighWater( void );
 
  protected:
   std::string clientName;
+  bool dropWarned_;
 
+  bool queueMessage( const unsigned char *message, int nBytes, unsigned long long time );
   void connect( void );
   void initialize( const std::string& clientName );
 };
@@ -679,9 +1012,20 @@ class MidiOutAlsa: public MidiOutApi
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
   void sendMessage( std::vector<unsigned char> *message );
+  void sendMessage( const unsigned char *message, size_t size );
+  void sendMessages( std::vector<unsigned char> *messages );
+  bool trySend( const unsigned char *message, size_t size );
+  void sendChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 );
+  double getOutputTime( void );
+  void sendMessageAt( double timeStamp, const unsigned char *message, size_t size );
+  void setOutputTempo( unsigned int usPerQuarter, unsigned int ppq );
+  void sendMessageAtTick( unsigned long tick, const unsigned char *message, size_t size );
 
  protected:
   void initialize( const std::string& clientName );
+  bool outputMessage( const unsigned char *message, unsigned int nBytes );
+  bool outputChannelMessage( unsigned char status, unsigned char data1, unsigned char data2 );
+  bool startOutputQueue( void );
 };
 
 #endif
@@ -716,6 +1060,7 @@ class MidiOutWinMM: public MidiOutApi
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
   void sendMessage( std::vector<unsigned char> *message );
+  using MidiOutApi::sendMessage;  // copies into a vector
 
  protected:
   void initialize( const std::string& clientName );
@@ -751,6 +1096,10 @@ class MidiOutDummy: public MidiOutApi
   unsigned int getPortCount( void ) { return 0; }
   std::string getPortName( unsigned int /*portNumber*/ ) { return ""; }
   void sendMessage( std::vector<unsigned char> * /*message*/ ) {}
+  void sendMessage( const unsigned char * /*message*/, size_t /*size*/ ) {}
+  void sendMessages( std::vector<unsigned char> * /*messages*/ ) {}
+  void sendChannelMessage( unsigned char /*status*/, unsigned char /*data1*/, unsigned char /*data2*/ ) {}
+  void sendMessageAt( double /*timeStamp*/, const unsigned char * /*message*/, size_t /*size*/ ) {}
 
  protected:
   void initialize( const std::string& /*clientName*/ ) {}
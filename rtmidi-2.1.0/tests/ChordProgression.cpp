@@ -0,0 +1,123 @@
+//*******************************************************************************************//
+//  ChordProgression.cpp
+//
+//  Implementation of the weighted Markov chord progression (see ChordProgression.h).
+//*******************************************************************************************//
+
+#include "ChordProgression.h"
+
+static inline bool isDegree( int degree )
+{
+  return degree >= 1 && degree <= (int) ChordProgression::DEGREES;
+}
+
+ChordProgression :: ChordProgression( unsigned int order )
+  : order_( order ), nContexts_( 1 ), context_( 0 ), compiled_( false )
+{
+  if ( order_ < 1 ) order_ = 1;
+  if ( order_ > MAX_ORDER ) order_ = MAX_ORDER;
+  for ( unsigned int i = 0; i < order_; i++ ) nContexts_ *= DEGREES;
+
+  weights_.assign( nContexts_ * DEGREES, 0.0 );
+  probability_.assign( nContexts_ * DEGREES, 0.0 );
+  alias_.assign( nContexts_ * DEGREES, 0 );
+}
+
+void ChordProgression :: setWeight( int previous, int next, double weight )
+{
+  if ( !isDegree( previous ) || !isDegree( next ) || weight < 0.0 ) return;
+
+  // Every context whose newest degree is 'previous'.
+  for ( unsigned int context = previous - 1; context < nContexts_; context += DEGREES )
+    weights_[context * DEGREES + next - 1] = weight;
+  compiled_ = false;
+}
+
+void ChordProgression :: setWeight( const std::vector<int> &context, int next, double weight )
+{
+  if ( context.size() != order_ || !isDegree( next ) || weight < 0.0 ) return;
+
+  unsigned int index = 0;
+  for ( unsigned int i = 0; i < order_; i++ ) {
+    if ( !isDegree( context[i] ) ) return;
+    index = index * DEGREES + context[i] - 1;
+  }
+  weights_[index * DEGREES + next - 1] = weight;
+  compiled_ = false;
+}
+
+void ChordProgression :: compile( void )
+{
+  unsigned int small[DEGREES], large[DEGREES];
+  double scaled[DEGREES];
+
+  for ( unsigned int context = 0; context < nContexts_; context++ ) {
+    const double *weights = &weights_[context * DEGREES];
+    double *probability = &probability_[context * DEGREES];
+    unsigned char *alias = &alias_[context * DEGREES];
+
+    double sum = 0.0;
+    for ( unsigned int i = 0; i < DEGREES; i++ ) sum += weights[i];
+
+    if ( sum <= 0.0 ) {
+      // Nowhere to go: return to the tonic.
+      for ( unsigned int i = 0; i < DEGREES; i++ ) {
+        probability[i] = 0.0;
+        alias[i] = 0;
+      }
+      continue;
+    }
+
+    // Vose's alias method: split the columns in those below and above
+    // the mean, then let every small column borrow from a large one.
+    unsigned int nSmall = 0, nLarge = 0;
+    for ( unsigned int i = 0; i < DEGREES; i++ ) {
+      scaled[i] = weights[i] * DEGREES / sum;
+      if ( scaled[i] < 1.0 ) small[nSmall++] = i;
+      else large[nLarge++] = i;
+    }
+    while ( nSmall > 0 && nLarge > 0 ) {
+      unsigned int s = small[--nSmall];
+      unsigned int l = large[--nLarge];
+      probability[s] = scaled[s];
+      alias[s] = (unsigned char) l;
+      scaled[l] = ( scaled[l] + scaled[s] ) - 1.0;
+      if ( scaled[l] < 1.0 ) small[nSmall++] = l;
+      else large[nLarge++] = l;
+    }
+    // Whatever is left is (up to rounding) exactly full.
+    while ( nLarge > 0 ) {
+      unsigned int l = large[--nLarge];
+      probability[l] = 1.0;
+      alias[l] = (unsigned char) l;
+    }
+    while ( nSmall > 0 ) {
+      unsigned int s = small[--nSmall];
+      probability[s] = 1.0;
+      alias[s] = (unsigned char) s;
+    }
+  }
+
+  compiled_ = true;
+}
+
+void ChordProgression :: reset( int degree )
+{
+  if ( !isDegree( degree ) ) degree = 1;
+  context_ = 0;
+  for ( unsigned int i = 0; i < order_; i++ )
+    context_ = context_ * DEGREES + degree - 1;
+}
+
+int ChordProgression :: next( RandomEngine &random )
+{
+  if ( !compiled_ ) compile();
+
+  // Pick a column uniformly, then either keep it or take its alias.
+  unsigned int index = context_ * DEGREES + random.nextInt( DEGREES );
+  double u = random.nextDouble();
+  unsigned int degree = ( u < probability_[index] ) ? index % DEGREES : alias_[index];
+
+  context_ = ( context_ * DEGREES + degree ) % nContexts_;
+  return (int) degree + 1;
+}
@@ -0,0 +1,81 @@
+//*******************************************************************************************//
+//  ChordProgression.h
+//
+//  A weighted Markov chain over the seven scale degrees of a key.
+//
+//  The next degree depends on the last getOrder() degrees (the context).
+//  Every context has its own row of weights, and compile() turns each row
+//  into an alias table (Vose's method), so drawing the next degree always
+//  costs two random numbers and one table lookup, whatever the weights and
+//  however long the progression runs.
+//*******************************************************************************************//
+
+#ifndef CHORDPROGRESSION_H
+#define CHORDPROGRESSION_H
+
+#include <vector>
+#include "RandomEngine.h"
+
+class ChordProgression
+{
+ public:
+
+  //! Number of degrees in a key.
+  static const unsigned int DEGREES = 7;
+
+  //! Maximum supported order of the chain.
+  static const unsigned int MAX_ORDER = 4;
+
+  //! The constructor.
+  /*!
+    \param order The number of previous degrees the next one depends
+                 on (1 to MAX_ORDER).  All weights start at 0.
+  */
+  ChordProgression( unsigned int order = 1 );
+
+  //! Returns the order of the chain.
+  unsigned int getOrder( void ) const { return order_; }
+
+  //! Sets the weight of moving from degree \e previous to degree \e next.
+  /*!
+    The weight is set for every context whose last degree is \e
+    previous, so with a higher order chain it acts as a first-order
+    default that can then be refined by the context version below.
+    Degrees are numbered 1 to 7.
+  */
+  void setWeight( int previous, int next, double weight );
+
+  //! Sets the weight of moving to degree \e next after the degrees in \e context.
+  /*!
+    \e context holds getOrder() degrees, the oldest first.
+  */
+  void setWeight( const std::vector<int> &context, int next, double weight );
+
+  //! Builds the alias tables from the current weights.
+  /*!
+    This is done automatically by next() when the weights have
+    changed.  A context whose weights are all 0 returns to degree 1.
+  */
+  void compile( void );
+
+  //! Restarts the progression on \e degree (the whole context is set to it).
+  void reset( int degree );
+
+  //! Draws the next degree, in constant time, and appends it to the context.
+  int next( RandomEngine &random );
+
+  //! Returns the last degree of the progression.
+  int getDegree( void ) const { return (int) ( context_ % DEGREES ) + 1; }
+
+ protected:
+  unsigned int order_;
+  unsigned int nContexts_;
+  unsigned int context_;  // last order_ degrees (0 to 6), in base 7, the newest last
+  bool compiled_;
+
+  std::vector<double> weights_;      // nContexts_ rows of DEGREES weights
+  std::vector<double> probability_;  // alias tables, same layout
+  std::vector<unsigned char> alias_;
+};
+
+#endif
@@ -0,0 +1,106 @@
+//*******************************************************************************************//
+//  MeasureStream.cpp
+//
+//  Implementation of the MeasureStream (see MeasureStream.h).
+//*******************************************************************************************//
+
+#include "MeasureStream.h"
+#include "Playback.h"
+
+// How long the consumer sleeps between two polls of an empty queue.
+const long long CONSUMER_POLL_NS = 100000;
+
+MeasureStream :: MeasureStream( void )
+  : generator_( 0 ), pollTime_( 0 ), running_( false ), finished_( true ), stopRequested_( false ),
+    cancelled_( false ), generated_( 0 ), underruns_( 0 ), consumed_( 0 )
+{
+  // Write the buffers once, so their pages are faulted in before the
+  // first note rather than while the piece plays.
+  for ( unsigned int i = 0; i < DEPTH; i++ ) {
+    std::vector<MidiEvent> &events = queue_.slot( i ).events;
+    events.resize( Metamorphosis::MAX_MEASURE_EVENTS );
+    events.clear();
+  }
+}
+
+MeasureStream :: ~MeasureStream( void )
+{
+  stop();
+}
+
+bool MeasureStream :: start( Metamorphosis &generator, double pollMs, unsigned int firstBar )
+{
+  stop();
+  while ( queue_.readSlot() ) queue_.commitRead();
+
+  generator_ = &generator;
+  generator_->begin( firstBar );
+  pollTime_ = (long long) ( pollMs * 1000000.0 );
+  finished_.store( false );
+  stopRequested_.store( false );
+  cancelled_.store( false );
+  generated_.store( 0 );
+  underruns_.store( 0 );
+  consumed_ = 0;
+
+  if ( pthread_create( &thread_, NULL, generatorThread, this ) != 0 ) {
+    finished_.store( true );
+    return false;
+  }
+  running_ = true;
+  return true;
+}
+
+void MeasureStream :: stop( void )
+{
+  if ( !running_ ) return;
+  stopRequested_.store( true );
+  pthread_join( thread_, NULL );
+  running_ = false;
+}
+
+void *MeasureStream :: generatorThread( void *ptr )
+{
+  MeasureStream *stream = static_cast<MeasureStream *> (ptr);
+
+  while ( !stream->stopRequested_.load( std::memory_order_relaxed ) ) {
+    Timeline *measure = stream->queue_.writeSlot();
+    if ( measure == 0 ) {
+      // Far enough ahead of the playback.
+      DeadlineScheduler::sleepUntil( DeadlineScheduler::now() + stream->pollTime_ );
+      continue;
+    }
+    if ( stream->generator_->renderNext( *measure ) == false ) break;
+    stream->queue_.commitWrite();
+    stream->generated_.fetch_add( 1, std::memory_order_relaxed );
+  }
+
+  stream->finished_.store( true, std::memory_order_release );
+  return 0;
+}
+
+const Timeline *MeasureStream :: front( void )
+{
+  bool waiting = false;
+  for ( ;; ) {
+    if ( isCancelled() ) return 0;
+    Timeline *measure = queue_.readSlot();
+    if ( measure ) return measure;
+
+    // Check the queue once more after seeing the generator finish, since
+    // it may have published its last measure just before.
+    if ( finished_.load( std::memory_order_acquire ) ) return queue_.readSlot();
+
+    // The generator has fallen behind the playback (waiting for the
+    // very first measure is just the start of the stream).
+    if ( !waiting && consumed_ > 0 ) underruns_.fetch_add( 1, std::memory_order_relaxed );
+    waiting = true;
+    DeadlineScheduler::sleepUntil( DeadlineScheduler::now() + CONSUMER_POLL_NS );
+  }
+}
+
+void MeasureStream :: pop( void )
+{
+  queue_.commitRead();
+  consumed_++;
+}
@@ -0,0 +1,100 @@
+//*******************************************************************************************//
+//  MeasureStream.h
+//
+//  Streams a Metamorphosis piece one measure at a time, overlapping its
+//  generation with its playback.
+//
+//  A generator thread renders the measures just ahead of the playback
+//  cursor into a small SpscQueue of preallocated measure buffers, and the
+//  real-time sender consumes them (see playStream() in Playback.h).  The
+//  first measure is ready a few microseconds after start(), and the event
+//  storage is DEPTH measures whatever the length of the piece, even when
+//  the generator is in endless mode.
+//
+//  The stream counts the measures generated and the underruns (the times
+//  the playback found no measure ready), so that a long-running
+//  installation can check that the generation keeps up with the playback.
+//*******************************************************************************************//
+
+#ifndef MEASURESTREAM_H
+#define MEASURESTREAM_H
+
+#include <atomic>
+#include <pthread.h>
+#include "Metamorphosis.h"
+#include "SpscQueue.h"
+#include "Timeline.h"
+
+class MeasureStream
+{
+ public:
+
+  //! Number of measures the generator may run ahead of the playback.
+  static const unsigned int DEPTH = 4;
+
+  //! The constructor preallocates the measure buffers and faults their pages in.
+  MeasureStream( void );
+
+  //! The destructor stops the generator thread if it is still running.
+  ~MeasureStream( void );
+
+  //! Begins a new piece with \e generator and starts the generator thread.
+  /*!
+    The arrangement is chosen before the function returns, so \e
+    generator can be inspected (but not changed) while the piece is
+    streamed.  When the queue is full, the generator thread sleeps for
+    \e pollMs milliseconds before trying again.  Returns false if the
+    thread could not be created.  The piece is streamed from bar \e
+    firstBar (see Metamorphosis::begin()).
+  */
+  bool start( Metamorphosis &generator, double pollMs, unsigned int firstBar = 0 );
+
+  //! Stops the generator thread and waits for it to finish.
+  void stop( void );
+
+  //! Returns the next measure, waiting for it if it is not rendered yet.
+  /*!
+    Returns 0 once every measure of the piece has been consumed.  The
+    measure remains valid until pop() is called.
+  */
+  const Timeline *front( void );
+
+  //! Releases the measure returned by front() to the generator.
+  void pop( void );
+
+  //! Makes front() return 0 from now on, e.g. to stop an endless piece.
+  /*!
+    This only sets a lock-free flag, so it can be called from a
+    signal handler.  The generator thread is stopped by stop().
+  */
+  void cancel( void ) { cancelled_.store( true ); }
+
+  //! Returns true if cancel() has been called since start().
+  bool isCancelled( void ) const { return cancelled_.load( std::memory_order_relaxed ); }
+
+  //! Returns the number of measures rendered since start() (any thread).
+  unsigned long getMeasuresGenerated( void ) const { return generated_.load( std::memory_order_relaxed ); }
+
+  //! Returns the number of times front() had to wait for a measure since start() (any thread).
+  unsigned long getUnderruns( void ) const { return underruns_.load( std::memory_order_relaxed ); }
+
+  //! Returns the number of measures rendered but not yet played.
+  unsigned int getQueuedMeasures( void ) const { return queue_.size(); }
+
+ protected:
+  static void *generatorThread( void *ptr );
+
+  SpscQueue<Timeline, DEPTH> queue_;
+  Metamorphosis *generator_;
+  long long pollTime_;  // nanoseconds
+  pthread_t thread_;
+  bool running_;
+  std::atomic<bool> finished_;
+  std::atomic<bool> stopRequested_;
+  std::atomic<bool> cancelled_;
+  std::atomic<unsigned long> generated_;
+  std::atomic<unsigned long> underruns_;
+  unsigned long consumed_;  // measures popped by the playback
+};
+
+#endif
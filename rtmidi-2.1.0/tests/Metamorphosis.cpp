@@ -0,0 +1,512 @@
+//*******************************************************************************************//
+//  Metamorphosis.cpp
+//
+//  Implementation of the Metamorphosis generator (see Metamorphosis.h).
+//*******************************************************************************************//
+
+#include "Metamorphosis.h"
+#include <cstdlib>
+
+// Velocity given to the notes of the RIGHT HAND in the opening patterns
+// (which are much more lower in the scale).
+const unsigned char BASS_VELOCITY = 115;
+
+// Number of measures in a phrase of the second and third parts.
+const unsigned int PHRASE_MEASURES = 5;
+
+// Progressions drawn for a phrase before its cadence is forced.  About
+// one in 12 progressions returns to i in time, so this is practically
+// never reached.
+const unsigned int MAX_PHRASE_DRAWS = 256;
+
+// Size of the arrangement built by arrange(), for which the storage is
+// reserved once, so re-arranging in endless mode never allocates.
+const unsigned int ARRANGEMENT_MEASURES = 4 + 2 * PHRASE_MEASURES + 4;
+const unsigned int ARRANGEMENT_SECTIONS = 6;
+const unsigned int ARRANGEMENT_NODES = 4;
+
+// Velocities standing for Measure::accent and Measure::velocity in the
+// cached measures, which are shared by measures of different dynamics.
+const unsigned char ACCENT_CODE = 1;
+const unsigned char VELOCITY_CODE = 2;
+
+// Rhythmic values of the notes, in ticks.
+const unsigned int TRIPLET = 1;
+const unsigned int EIGHTH = TICKS_PER_EIGHTH;
+const unsigned int QUARTER = 2 * TICKS_PER_EIGHTH;
+const unsigned int WHOLE = TICKS_PER_MEASURE;
+
+// Appends a NoteOn event to the timeline, and the NoteOff that ends
+// the note after \e duration ticks.  The NoteOff is a NoteOn with
+// velocity 0, so that the whole piece is a single run of the same
+// status (see RtMidiOut::setRunningStatus()).
+static inline void playNote( Timeline &timeline, unsigned long tick, unsigned int duration,
+                             int note, unsigned char velocity )
+{
+  MidiEvent event;
+  event.tick = tick;
+  event.status = 144;
+  event.note = (unsigned char) note;
+  event.velocity = velocity;
+  timeline.events.push_back( event );
+
+  event.tick = tick + duration;
+  event.velocity = 0;
+  timeline.events.push_back( event );
+}
+
+// Sorts the events from \e first on by tick, the NoteOffs of a tick
+// before its NoteOns (so that a note struck again is first released),
+// keeping the order of the NoteOns.  An insertion sort, since a measure
+// is only a few dozen events and nothing may be allocated.
+static void sortEvents( Timeline &timeline, unsigned long first )
+{
+  std::vector<MidiEvent> &events = timeline.events;
+  for ( unsigned long i = first + 1; i < events.size(); i++ ) {
+    MidiEvent event = events[i];
+    unsigned long j = i;
+    for ( ; j > first && ( events[j-1].tick > event.tick ||
+                           ( events[j-1].tick == event.tick && events[j-1].velocity > 0 && event.velocity == 0 ) ); j-- )
+      events[j] = events[j-1];
+    events[j] = event;
+  }
+}
+
+Metamorphosis :: Metamorphosis( void )
+  : progression_( 1 ), random_( 1 ), seed_( 1 ), tonality_( 0 ), nBars_( 0 ), nextMeasure_( 0 ),
+    nextTick_( 0 ), endless_( false ), nCached_( 0 )
+{
+  // Every distinct measure is rendered once into the cache, which is
+  // reserved here for all of them so rendering never allocates.
+  unsigned long nEvents = 0;
+  for ( unsigned int pattern = 0; pattern < PATTERNS; pattern++ )
+    nEvents += getEventCount( (Pattern) pattern ) * 12 * 7;
+  cachedEvents_.reserve( nEvents );
+  scratch_.events.reserve( MAX_MEASURE_EVENTS );
+  measures_.reserve( ARRANGEMENT_MEASURES );
+  sections_.reserve( ARRANGEMENT_SECTIONS );
+  nodes_.reserve( ARRANGEMENT_NODES );
+  for ( unsigned int pattern = 0; pattern < PATTERNS; pattern++ )
+    for ( unsigned int tonality = 0; tonality < 12; tonality++ )
+      for ( unsigned int degree = 0; degree < 7; degree++ )
+        cache_[pattern][tonality][degree].count = 0;
+
+  // SO I RESTRICTED THE PROBLEM TO DIATONIC CHORDS (like piece # 2 in Metamorphosis)
+  // THE EASIEST CASE (there is no ornamentations -notes outside the tonality-).
+
+  // I USED A MINOR TONALITY JUST LIKE GLASS IN ALL HIS WORKS IN METAMORPHOSIS
+
+  // AND I RESTRICTED THE CHORD PROGRESSIONS TO THE WAY HE GENERALLY MOVES BETWEEN CHORDS
+  // i --> III, VI --> III, VI or iv, ii-
+  // iv and ii- --> can move to themselves or to VII, v
+  // And VII, v --> can move to themselves or return to i
+  // ALL THESE CASES ARE ALLOWED, THROUGH A MARKOV CHAIN WHERE EACH NEXT CHORD
+  // HAS A WEIGHT ASSOCIATED TO IT
+
+  //--------------------//
+  //  CHORD PROGRESSION //
+  //--------------------//
+
+  // Degrees: i = 1, ii- = 2, III = 3, iv = 4, v = 5, VI = 6, VII = 7
+  // III and VI are preferred over iv and ii- (the earlier, fixed progressions
+  // only used {1} --> {3, 6} --> {3, 6} --> {5, 7} --> Again {1}).
+  progression_.setWeight( 1, 3, 1.0 );
+  progression_.setWeight( 1, 6, 1.0 );
+
+  progression_.setWeight( 3, 3, 1.0 );
+  progression_.setWeight( 3, 6, 1.0 );
+  progression_.setWeight( 3, 4, 0.5 );
+  progression_.setWeight( 3, 2, 0.5 );
+  progression_.setWeight( 6, 3, 1.0 );
+  progression_.setWeight( 6, 6, 1.0 );
+  progression_.setWeight( 6, 4, 0.5 );
+  progression_.setWeight( 6, 2, 0.5 );
+
+  progression_.setWeight( 4, 4, 1.0 );
+  progression_.setWeight( 4, 2, 1.0 );
+  progression_.setWeight( 4, 7, 1.0 );
+  progression_.setWeight( 4, 5, 1.0 );
+  progression_.setWeight( 2, 4, 1.0 );
+  progression_.setWeight( 2, 2, 1.0 );
+  progression_.setWeight( 2, 7, 1.0 );
+  progression_.setWeight( 2, 5, 1.0 );
+
+  progression_.setWeight( 7, 7, 1.0 );
+  progression_.setWeight( 7, 5, 1.0 );
+  progression_.setWeight( 7, 1, 2.0 );
+  progression_.setWeight( 5, 7, 1.0 );
+  progression_.setWeight( 5, 5, 1.0 );
+  progression_.setWeight( 5, 1, 2.0 );
+  progression_.compile();
+}
+
+std::string Metamorphosis :: getPatternName( Pattern pattern )
+{
+  switch ( pattern ) {
+  case OPENING_A: return "Opening A";
+  case OPENING_B: return "Opening B";
+  case CHORDS:    return "Chords";
+  case TRIPLETS:  return "Triplets";
+  }
+  return "";
+}
+
+unsigned int Metamorphosis :: getEventCount( Pattern pattern )
+{
+  // A NoteOn and a NoteOff for every note.
+  switch ( pattern ) {
+  case OPENING_A: return 2 * ( 4 * 2 + 4 * 1 );      // 4 steps with 2 notes, 4 with 1
+  case OPENING_B: return 2 * ( 4 * 2 + 4 * 1 + 2 );  // plus the root in 2 octaves
+  case CHORDS:    return 2 * ( 4 * 2 + 4 * 1 + 5 * 3 );
+  case TRIPLETS:  return 2 * 4 * ( 3 + 1 + 1 + 2 + 1 + 1 );
+  }
+  return 0;
+}
+
+void Metamorphosis :: addMeasure( Pattern pattern, int degree, unsigned char accent, unsigned char velocity )
+{
+  Measure measure;
+  measure.pattern = pattern;
+  measure.degree = degree;
+  measure.accent = accent;
+  measure.velocity = velocity;
+  measures_.push_back( measure );
+}
+
+unsigned int Metamorphosis :: addSection( unsigned int first, unsigned int count )
+{
+  Section section;
+  section.first = first;
+  section.count = count;
+  sections_.push_back( section );
+  return sections_.size() - 1;
+}
+
+void Metamorphosis :: addNode( unsigned int section, unsigned int repeats, int bridge )
+{
+  Node node;
+  node.section = section;
+  node.repeats = repeats;
+  node.bridge = bridge;
+  node.firstBar = nBars_;
+  nodes_.push_back( node );
+
+  unsigned int length = sections_[section].count;
+  if ( bridge >= 0 ) length += sections_[bridge].count;
+  nBars_ += repeats * length;
+}
+
+const Metamorphosis::Measure& Metamorphosis :: getMeasure( unsigned int bar ) const
+{
+  // Last node starting at or before bar.
+  unsigned int low = 0, high = nodes_.size();
+  while ( high - low > 1 ) {
+    unsigned int middle = ( low + high ) / 2;
+    if ( nodes_[middle].firstBar <= bar ) low = middle;
+    else high = middle;
+  }
+
+  // Then the place of bar in a repeat of the section and its bridge.
+  const Node &node = nodes_[low];
+  const Section &section = sections_[node.section];
+  unsigned int length = section.count;
+  if ( node.bridge >= 0 ) length += sections_[node.bridge].count;
+  unsigned int offset = ( bar - node.firstBar ) % length;
+  if ( offset < section.count ) return measures_[section.first + offset];
+  return measures_[sections_[node.bridge].first + offset - section.count];
+}
+
+void Metamorphosis :: compose( Timeline &timeline )
+{
+  arrange( random_ );
+
+  unsigned long nEvents = 0;
+  for ( unsigned int i = 0; i < nBars_; i++ )
+    nEvents += getEventCount( getMeasure( i ).pattern );
+
+  timeline.clear();
+  timeline.events.reserve( nEvents );
+  for ( unsigned int i = 0; i < nBars_; i++ ) {
+    renderMeasure( getMeasure( i ), timeline.length, timeline );
+    timeline.length += TICKS_PER_MEASURE;
+  }
+  nextMeasure_ = nBars_;
+  nextTick_ = timeline.length;
+}
+
+void Metamorphosis :: begin( unsigned int firstBar )
+{
+  arrange( random_ );
+  nextMeasure_ = firstBar;
+  nextTick_ = 0;
+}
+
+bool Metamorphosis :: renderNext( Timeline &measure )
+{
+  measure.clear();
+  if ( nextMeasure_ >= nBars_ ) {
+    if ( !endless_ ) return false;
+
+    // Go on with a new arrangement, right after the last measure.
+    arrange( random_ );
+    nextMeasure_ = 0;
+  }
+
+  renderMeasure( getMeasure( nextMeasure_++ ), nextTick_, measure );
+  nextTick_ += TICKS_PER_MEASURE;
+  measure.length = nextTick_;
+  return true;
+}
+
+void Metamorphosis :: choosePhrase( int *degrees, RandomEngine &random )
+{
+  // A phrase always starts in i and then follows the chord progression,
+  // which is drawn again until it resolves to i on the last measure
+  // (through v or VII, the only degrees that move to i).
+  degrees[0] = 1;
+  for ( unsigned int draw = 0; draw < MAX_PHRASE_DRAWS; draw++ ) {
+    progression_.reset( 1 );
+    for ( unsigned int i = 1; i < PHRASE_MEASURES; i++ )
+      degrees[i] = progression_.next( random );
+    if ( degrees[PHRASE_MEASURES - 1] == 1 ) return;
+  }
+  degrees[PHRASE_MEASURES - 1] = 1;
+}
+
+void Metamorphosis :: arrange( RandomEngine &random )
+{
+  measures_.clear();
+  sections_.clear();
+  nodes_.clear();
+  nBars_ = 0;
+
+  //---------------------//
+  // CHOOSING A TONALITY //
+  //---------------------//
+
+  // Obtains a random number between 0 and 11
+  // that corresponds to one tonality, where:
+  // 0 is A,    1 is A#,  2 is B,   3 is C,   4 is C#,  5 is D,
+  // 6 is D#,   7 is E,   8 is F,   9 is F#,  10 is G,  11 is G#
+  tonality_ = random.nextInt( 12 );
+
+  //----------------------//
+  //    FIRST PART        //
+  //----------------------//----------------------------------------------//
+  // This part is always in the FIRST chord (i) of the key (or tonality)  //
+  // Here there are no chord progressions,                                //
+  // we are always in i: CHORDS_IN_KEY[0]                                //
+  // the right hand plays (when it does) the root of the chord i          //
+  //----------------------------------------------------------------------//
+
+  // TimeSeq1 (A, A, B, A) is played 2 times,
+  // with a louder FIRST NOTE in the sequence:
+  addMeasure( OPENING_A, 1, 100, 80 );
+  addMeasure( OPENING_A, 1, 80, 80 );
+  addMeasure( OPENING_B, 1, 80, 80 );
+  addMeasure( OPENING_A, 1, 80, 80 );
+  unsigned int timeSeq1 = addSection( 0, 4 );
+  addNode( timeSeq1, 2 );
+
+  // The bridge sections are the end of TimeSeq1: TimeSeq1B alone,
+  // then TimeSeq1B and TimeSeq1A.
+  unsigned int bridge2 = addSection( 2, 1 );
+  unsigned int bridge3 = addSection( 2, 2 );
+
+  //----------------------//
+  //    SECOND PART       //
+  //----------------------//----------------------------------//
+  // This part moves from chord to chord in each measure,     //
+  // so it follows the possible chord progressions defined    //
+  // by the Markov chain progression_                         //
+  // The left hand behaves just like before                   //
+  // and the right hand plays the whole chord                 //
+  // (in an upper register -approx. C3 to C4-)                //
+  //----------------------------------------------------------//
+  int degrees2[PHRASE_MEASURES];
+  choosePhrase( degrees2, random );
+
+  //------------------//
+  //    THIRD PART    //
+  //------------------//--------------------------------------------------//
+  // This part changes chord in every measure, the chord progressions     //
+  // are similar to the ones described by progression_                   //
+  // The Left hand does what it has been doing all this time              //
+  // (Low Quarter notes and Eighth notes moving a little higher than it)  //
+  // The Right hand plays Triplets over each Eighth note.                 //
+  //----------------------------------------------------------------------//
+  int degrees3[PHRASE_MEASURES];
+  choosePhrase( degrees3, random );
+
+  unsigned int first = measures_.size();
+  for (unsigned int i = 0; i < PHRASE_MEASURES; i++)
+    addMeasure( CHORDS, degrees2[i], 80, 80 );
+  unsigned int timeSeq2 = addSection( first, PHRASE_MEASURES );
+
+  first = measures_.size();
+  for (unsigned int i = 0; i < PHRASE_MEASURES; i++)
+    addMeasure( TRIPLETS, degrees3[i], 80, 80 );
+  unsigned int timeSeq3 = addSection( first, PHRASE_MEASURES );
+
+  // TimeSeq2 and TimeSeq1B (bridge section) are played 2 times:
+  addNode( timeSeq2, 2, bridge2 );
+
+  // TimeSeq3 and the bridge section (which now consist of both TimeSeq1B and TimeSeq1A) are played 2 times:
+  addNode( timeSeq3, 2, bridge3 );
+
+  //----------------//
+  //    ENDING      //
+  //----------------//
+
+  // TimeSeq1 again, 2 times, a little softer:
+  first = measures_.size();
+  addMeasure( OPENING_A, 1, 90, 70 );
+  addMeasure( OPENING_A, 1, 70, 70 );
+  addMeasure( OPENING_B, 1, 70, 70 );
+  addMeasure( OPENING_A, 1, 70, 70 );
+  addNode( addSection( first, 4 ), 2 );
+}
+
+void Metamorphosis :: writeMeasure( const Measure &measure, unsigned long startTick, Timeline &timeline ) const
+{
+  unsigned long tick = startTick;
+  unsigned long first = timeline.events.size();
+  unsigned char velocity;
+
+  // LEFT HAND:
+  // ----------
+  // The actual chord to be played in the limits, from lowest to highest:
+  // the 1st note is the lowest --> used as bass (quarter note)
+  // Last 2 notes are the highest --> used as the eighth notes (played over the quarter note)
+  const unsigned char *LPlayingChord = getVoicing( LEFT_HAND, tonality_, measure.degree ).notes;
+
+  if ( measure.pattern == OPENING_A || measure.pattern == OPENING_B ) {
+    // RIGHT HAND:
+    // -----------
+    //Base line for the RIGHT HAND: A0 = 21
+    int longNote = getRootNote( tonality_, measure.degree, 21 );
+
+    for (unsigned int i = 0; i < 8; i++){
+      velocity = ( i == 0 ) ? measure.accent : measure.velocity;
+      if(i%2 == 0){
+        playNote( timeline, tick, QUARTER, LPlayingChord[0], velocity ); //Quarter
+        playNote( timeline, tick, EIGHTH, LPlayingChord[1], velocity ); //low Eighth note
+      }else{
+        playNote( timeline, tick, EIGHTH, LPlayingChord[2], velocity ); //high Eighth note
+      }
+      if(measure.pattern == OPENING_B && i == 0){
+        playNote( timeline, tick, WHOLE, longNote, BASS_VELOCITY );
+        playNote( timeline, tick, WHOLE, longNote + 12, BASS_VELOCITY );
+      }
+      tick += TICKS_PER_EIGHTH;
+    }
+  }
+  else if ( measure.pattern == CHORDS ) {
+    // RIGHT HAND:
+    // -----------
+    // The actual chord to be played in the limits C4 (60) to D5 (74)
+    const unsigned char *RPlayingChord = getVoicing( CHORD_HAND, tonality_, measure.degree ).notes;
+
+    for (unsigned int i = 0; i < 8; i++){
+      velocity = ( i == 0 ) ? measure.accent : measure.velocity;
+      //Left hand information
+      if(i%2 == 0){
+        playNote( timeline, tick, QUARTER, LPlayingChord[0], velocity );  //Quarter
+        playNote( timeline, tick, EIGHTH, LPlayingChord[1], velocity );  //low Eighth note
+      }else{
+        playNote( timeline, tick, EIGHTH, LPlayingChord[2], velocity );  //high Eighth note
+      }
+      //Right hand information: eigth, quarter, quarter, quarter, eigth note
+      if(i == 0 or i == 1 or i == 3 or i == 5 or i == 7){
+        unsigned int duration = ( i == 0 || i == 7 ) ? EIGHTH : QUARTER;
+        for (unsigned int indexNote = 0; indexNote < 3; indexNote++){
+          playNote( timeline, tick, duration, RPlayingChord[indexNote], velocity );
+        }
+      }
+      tick += TICKS_PER_EIGHTH;
+    }
+  }
+  else if ( measure.pattern == TRIPLETS ) {
+    // RIGHT HAND:
+    // -----------
+    // The actual chord to be played in the limits F4 (65) to E5 (76),
+    // from lowest to highest
+    const unsigned char *chord = getVoicing( TRIPLET_HAND, tonality_, measure.degree ).notes;
+    const int RPlayingChord[6] = { chord[0], chord[1], chord[2], chord[0] + 12, chord[2], chord[1] };
+    // So RPlayingChord has 6 notes,
+    // 2 triplets corresponding to each Eighth note in the Left Hand
+    // It moves along the chord notes, first in an upward direction:
+    // 1st --> 2nd --> 3rd  (lowest to highest)
+    // [in order to get to the 1st again but an octave higher]
+    // and then it moves in the downward direction:
+    // 1st (one octave higher) --> 3nd --> 2nd
+    // [in order to begin again with the 1st in the original octave]
+
+    // The smallest unit in the Third Part is the
+    // sixteenth note (as part of a triplet group), that is, one tick:
+    // 8 eighth notes * 3 triplet = 24 units on each measure.
+    for (unsigned int i = 0; i < TICKS_PER_MEASURE; i++){
+      velocity = ( i == 0 ) ? measure.accent : measure.velocity;
+      if(i%6 == 0){
+        playNote( timeline, tick, QUARTER, LPlayingChord[0], velocity );  //Left: Quarter
+        playNote( timeline, tick, EIGHTH, LPlayingChord[1], velocity );  //Left: Low Eighth note
+        playNote( timeline, tick, TRIPLET, RPlayingChord[0], velocity );  //Right Hand (1st note)
+      }else if(i%6 == 1){
+        playNote( timeline, tick, TRIPLET, RPlayingChord[1], velocity );  //Right Hand (2nd note)
+      }else if(i%6 == 2){
+        playNote( timeline, tick, TRIPLET, RPlayingChord[2], velocity );  //Right Hand (3rd note)
+      }else if(i%6 == 3){
+        playNote( timeline, tick, EIGHTH, LPlayingChord[2], velocity );  //Left: High Eighth note
+        playNote( timeline, tick, TRIPLET, RPlayingChord[3], velocity );  //Right Hand (4th note = 1st note an octave higher)
+      }else if(i%6 == 4){
+        playNote( timeline, tick, TRIPLET, RPlayingChord[4], velocity );  //Right Hand (5th note)
+      }else{
+        playNote( timeline, tick, TRIPLET, RPlayingChord[5], velocity );  //Right Hand (6th note)
+      }
+      tick++;
+    }
+  }
+
+  // Put the NoteOffs in their place among the NoteOns.
+  sortEvents( timeline, first );
+}
+
+void Metamorphosis :: renderMeasure( const Measure &measure, unsigned long startTick, Timeline &timeline )
+{
+  CachedMeasure &cached = cache_[measure.pattern][tonality_][measure.degree - 1];
+
+  if ( cached.count == 0 ) {
+    // First time this measure is played: render it from tick 0, with
+    // velocity codes in place of its dynamics.
+    Measure key = measure;
+    key.accent = ACCENT_CODE;
+    key.velocity = VELOCITY_CODE;
+    scratch_.clear();
+    writeMeasure( key, 0, scratch_ );
+
+    cached.first = cachedEvents_.size();
+    for ( unsigned int i = 0; i < scratch_.events.size(); i++ ) {
+      const MidiEvent &event = scratch_.events[i];
+      CachedEvent block;
+      block.tick = (unsigned char) event.tick;
+      block.status = event.status;
+      block.note = event.note;
+      block.velocity = event.velocity;
+      cachedEvents_.push_back( block );
+    }
+    cached.count = scratch_.events.size();
+    nCached_++;
+  }
+
+  const CachedEvent *block = &cachedEvents_[cached.first];
+  for ( unsigned int i = 0; i < cached.count; i++ ) {
+    MidiEvent event;
+    event.tick = startTick + block[i].tick;
+    event.status = block[i].status;
+    event.note = block[i].note;
+    if ( block[i].velocity == ACCENT_CODE ) event.velocity = measure.accent;
+    else if ( block[i].velocity == VELOCITY_CODE ) event.velocity = measure.velocity;
+    else event.velocity = block[i].velocity;
+    timeline.events.push_back( event );
+  }
+}
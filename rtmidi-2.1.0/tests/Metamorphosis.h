@@ -0,0 +1,202 @@
+//*******************************************************************************************//
+//  Metamorphosis.h
+//
+//  Generator of a piece in the style of the Metamorphosis works by Philip Glass
+//  (see midiout.cpp for a description of its three sections).
+//
+//  The generator first decides the arrangement of the piece (the tonality
+//  and the measures with their pattern and chord degree) and then renders
+//  every measure into a Timeline.  The arrangement is a small graph: the
+//  distinct measures are stored once, a section is a run of them, and the
+//  piece is a list of nodes, each playing a section a number of times with
+//  an optional bridge section after every repeat.  The repeats and bridges
+//  refer to the same measures instead of copying them, and a bar index (the
+//  first bar of every node) finds the measure at any bar with a binary
+//  search.  Every NoteOn is followed by its NoteOff after the rhythmic
+//  value of the note (quarter, eighth or triplet), so no note is left
+//  ringing.
+//
+//  A measure only depends on the tonality, its chord degree and its
+//  pattern (its dynamics are applied as it is copied), so each distinct
+//  measure is rendered once into a cache of compact, immutable event
+//  blocks and every later occurrence is copied from its block.  The cache
+//  holds at most 4 x 12 x 7 blocks however long the piece, and a long or
+//  endless piece costs a copy per measure.
+//*******************************************************************************************//
+
+#ifndef METAMORPHOSIS_H
+#define METAMORPHOSIS_H
+
+#include <string>
+#include <vector>
+#include "ChordProgression.h"
+#include "RandomEngine.h"
+#include "Timeline.h"
+#include "Voicings.h"
+
+class Metamorphosis
+{
+ public:
+
+  //! Rhythmic patterns a measure can be rendered with.
+  enum Pattern {
+    OPENING_A,  /*!< Left hand only: quarter note against 2 eighth notes (TimeSeq1A). */
+    OPENING_B,  /*!< Same, with the root banged in a low register on the downbeat (TimeSeq1B). */
+    CHORDS,     /*!< Left hand plus the whole chord in the right hand, off the beat (TimeSeq2C). */
+    TRIPLETS    /*!< Left hand plus triplets over each eighth note (TimeSeq3C). */
+  };
+
+  //! One measure of the arrangement.
+  struct Measure {
+    Pattern pattern;
+    int degree;
+    unsigned char accent;    // velocity of the first step
+    unsigned char velocity;  // velocity of the other steps
+  };
+
+  //! The constructor builds the chord tables.
+  Metamorphosis( void );
+
+  //! Seeds the random number engine owned by this generator.
+  /*!
+    Each generator draws from its own engine, so several of them can
+    compose concurrently without sharing any state, and the same seed
+    always gives the same piece.
+  */
+  void setSeed( unsigned long long seed ) { seed_ = seed; random_.setSeed( seed ); }
+
+  //! Returns the last seed given to setSeed().
+  unsigned long long getSeed( void ) const { return seed_; }
+
+  //! Returns the random number engine of this generator.
+  RandomEngine& getRandom( void ) { return random_; }
+
+  //! Chooses a tonality and the chord progressions and compiles the whole piece.
+  /*!
+    Any previous content of \e timeline is discarded.  The timeline
+    storage is reserved once for the exact number of events.
+  */
+  void compose( Timeline &timeline );
+
+  //! Chooses a tonality and the chord progressions of a new piece, without rendering it.
+  /*!
+    The measures are then rendered one at a time, in playing order, by
+    renderNext(), from bar \e firstBar (counted from 0) on.  Only the
+    arrangement (a few bytes per distinct measure) is kept, so a piece
+    can be streamed with constant event storage whatever its length.
+  */
+  void begin( unsigned int firstBar = 0 );
+
+  //! Renders the next measure of the piece begun by begin() into \e measure.
+  /*!
+    Any previous content of \e measure is discarded.  The event ticks
+    are counted from the first measure rendered after begin() and
+    \e measure.length is set to the end of the measure (where the
+    NoteOffs of its last notes are).  Nothing is allocated once
+    \e measure has room for MAX_MEASURE_EVENTS events.  Returns false,
+    leaving \e measure empty, after the last measure (never in endless
+    mode).
+  */
+  bool renderNext( Timeline &measure );
+
+  //! Sets the endless mode of renderNext() (off by default).
+  /*!
+    In endless mode, a new arrangement (with a new tonality and new
+    chord progressions) is chosen whenever the current one is over, and
+    its measures follow on the same tick count, so the piece never ends.
+    The arrangement storage is reused, so memory stays flat however long
+    the piece runs.
+  */
+  void setEndless( bool endless ) { endless_ = endless; }
+
+  //! Returns true if renderNext() is in endless mode.
+  bool isEndless( void ) const { return endless_; }
+
+  //! Returns the chord progression used by the second and third parts.
+  /*!
+    Its weights can be changed before composing a piece.
+  */
+  ChordProgression& getProgression( void ) { return progression_; }
+
+  //! Returns the tonality of the last composed piece (0 is A, 1 is A#, ...).
+  int getTonality( void ) const { return tonality_; }
+
+  //! Returns the number of bars of the last composed piece.
+  unsigned int getMeasureCount( void ) const { return nBars_; }
+
+  //! Returns the measure played at \e bar (less than getMeasureCount()), in O(log n).
+  const Measure& getMeasure( unsigned int bar ) const;
+
+  //! Returns the number of distinct measures the arrangement refers to.
+  unsigned int getDistinctMeasureCount( void ) const { return measures_.size(); }
+
+  //! Largest number of events a single measure renders to.
+  static const unsigned int MAX_MEASURE_EVENTS = 72;
+
+  //! Returns the number of distinct measures rendered into the cache so far.
+  unsigned int getCachedMeasureCount( void ) const { return nCached_; }
+
+  //! Returns a short name for \e pattern.
+  static std::string getPatternName( Pattern pattern );
+
+  //! Returns the number of events a measure with \e pattern renders to.
+  static unsigned int getEventCount( Pattern pattern );
+
+ protected:
+  void arrange( RandomEngine &random );
+  void choosePhrase( int *degrees, RandomEngine &random );
+  void addMeasure( Pattern pattern, int degree, unsigned char accent, unsigned char velocity );
+  unsigned int addSection( unsigned int first, unsigned int count );
+  void addNode( unsigned int section, unsigned int repeats, int bridge = -1 );
+  void renderMeasure( const Measure &measure, unsigned long startTick, Timeline &timeline );
+  void writeMeasure( const Measure &measure, unsigned long startTick, Timeline &timeline ) const;
+
+  // A cached event, its tick counted from the start of the measure.
+  struct CachedEvent {
+    unsigned char tick;
+    unsigned char status;
+    unsigned char note;
+    unsigned char velocity;  // 0 for a NoteOff, or a velocity code
+  };
+
+  // The events of a cached measure in cachedEvents_ (count is 0 until rendered).
+  struct CachedMeasure {
+    unsigned short first;
+    unsigned char count;
+  };
+
+  static const unsigned int PATTERNS = TRIPLETS + 1;
+
+  // A run of consecutive measures of measures_.
+  struct Section {
+    unsigned int first;
+    unsigned int count;
+  };
+
+  // A section played repeats times, each time followed by the bridge section (-1 for none).
+  struct Node {
+    unsigned int section;
+    unsigned int repeats;
+    int bridge;
+    unsigned int firstBar;  // the bar index
+  };
+
+  ChordProgression progression_;
+  RandomEngine random_;
+  unsigned long long seed_;
+  int tonality_;
+  std::vector<Measure> measures_;  // the distinct measures
+  std::vector<Section> sections_;
+  std::vector<Node> nodes_;        // in playing order
+  unsigned int nBars_;
+  unsigned int nextMeasure_;  // next bar rendered by renderNext()
+  unsigned long nextTick_;    // and its start tick
+  bool endless_;
+
+  CachedMeasure cache_[PATTERNS][12][7];  // by pattern, tonality and degree - 1
+  std::vector<CachedEvent> cachedEvents_;
+  Timeline scratch_;
+  unsigned int nCached_;
+};
+
+#endif
@@ -0,0 +1,98 @@
+//*******************************************************************************************//
+//  MidiFile.cpp
+//
+//  Implementation of the Standard MIDI File writer (see MidiFile.h).
+//*******************************************************************************************//
+
+#include "MidiFile.h"
+#include <fstream>
+
+// Appends a big-endian value of nBytes bytes.
+static void putValue( std::vector<unsigned char> &data, unsigned long value, unsigned int nBytes )
+{
+  while ( nBytes-- > 0 )
+    data.push_back( (unsigned char) ( ( value >> ( 8 * nBytes ) ) & 0xFF ) );
+}
+
+// Appends a variable-length quantity (used for delta times).
+static void putVariableLength( std::vector<unsigned char> &data, unsigned long value )
+{
+  unsigned char bytes[5];
+  unsigned int n = 0;
+  do {
+    bytes[n++] = (unsigned char) ( value & 0x7F );
+    value >>= 7;
+  } while ( value > 0 );
+  while ( n-- > 1 )
+    data.push_back( bytes[n] | 0x80 );
+  data.push_back( bytes[0] );
+}
+
+// Appends a track chunk whose body has already been encoded.
+static void putTrack( std::vector<unsigned char> &data, const std::vector<unsigned char> &track )
+{
+  data.push_back( 'M' ); data.push_back( 'T' ); data.push_back( 'r' ); data.push_back( 'k' );
+  putValue( data, track.size(), 4 );
+  data.insert( data.end(), track.begin(), track.end() );
+}
+
+void encodeMidiFile( const Timeline &timeline, const TempoMap &tempo, std::vector<unsigned char> &data )
+{
+  const std::vector<MidiEvent> &events = timeline.events;
+
+  data.clear();
+
+  // Header chunk: format 1, 2 tracks.
+  data.push_back( 'M' ); data.push_back( 'T' ); data.push_back( 'h' ); data.push_back( 'd' );
+  putValue( data, 6, 4 );
+  putValue( data, 1, 2 );
+  putValue( data, 2, 2 );
+  putValue( data, TICKS_PER_QUARTER, 2 );
+
+  // Tempo track: the time signature, then one tempo (in microseconds
+  // per quarter note) for each segment of the tempo map.
+  std::vector<unsigned char> track;
+  putVariableLength( track, 0 );
+  track.push_back( 0xFF ); track.push_back( 0x58 ); track.push_back( 0x04 );
+  track.push_back( 4 ); track.push_back( 2 ); track.push_back( 24 ); track.push_back( 8 );
+  unsigned long lastTick = 0;
+  for ( unsigned int i = 0; i < tempo.getSegmentCount(); i++ ) {
+    const TempoMap::Segment &segment = tempo.getSegment( i );
+    if ( i > 0 && segment.tick >= timeline.length ) break;
+    unsigned long quarter = (unsigned long) ( ( segment.tickDuration * TICKS_PER_QUARTER + 500 ) / 1000 );
+    if ( quarter > 0xFFFFFF ) quarter = 0xFFFFFF;
+    putVariableLength( track, segment.tick - lastTick );
+    track.push_back( 0xFF ); track.push_back( 0x51 ); track.push_back( 0x03 );
+    putValue( track, quarter, 3 );
+    lastTick = segment.tick;
+  }
+  putVariableLength( track, timeline.length > lastTick ? timeline.length - lastTick : 0 );
+  track.push_back( 0xFF ); track.push_back( 0x2F ); track.push_back( 0x00 );
+  putTrack( data, track );
+
+  // Note track: 4 bytes at most per event plus the end of track.
+  track.clear();
+  track.reserve( events.size() * 4 + 8 );
+  lastTick = 0;
+  for ( unsigned long i = 0; i < events.size(); i++ ) {
+    putVariableLength( track, events[i].tick - lastTick );
+    track.push_back( events[i].status );
+    track.push_back( events[i].note );
+    track.push_back( events[i].velocity );
+    lastTick = events[i].tick;
+  }
+  putVariableLength( track, timeline.length > lastTick ? timeline.length - lastTick : 0 );
+  track.push_back( 0xFF ); track.push_back( 0x2F ); track.push_back( 0x00 );
+  putTrack( data, track );
+}
+
+bool writeMidiFile( const std::string &fileName, const Timeline &timeline, const TempoMap &tempo )
+{
+  std::vector<unsigned char> data;
+  encodeMidiFile( timeline, tempo, data );
+
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary );
+  if ( !file ) return false;
+  file.write( (const char *) &data[0], data.size() );
+  return file.good();
+}
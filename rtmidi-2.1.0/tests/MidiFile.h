@@ -0,0 +1,30 @@
+//*******************************************************************************************//
+//  MidiFile.h
+//
+//  Offline rendering of a compiled Timeline to a Standard MIDI File.
+//*******************************************************************************************//
+
+#ifndef MIDIFILE_H
+#define MIDIFILE_H
+
+#include <string>
+#include <vector>
+#include "TempoMap.h"
+#include "Timeline.h"
+
+//! Encodes \e timeline as a type 1 Standard MIDI File into \e data.
+/*!
+  The file has two tracks: a tempo track (4/4 time signature and a
+  tempo event for every segment of \e tempo) and a track with all the
+  note events of the piece.  The division is the number of timeline
+  ticks per quarter note, so the events keep their exact ticks.
+*/
+void encodeMidiFile( const Timeline &timeline, const TempoMap &tempo, std::vector<unsigned char> &data );
+
+//! Writes \e timeline to \e fileName as a type 1 Standard MIDI File.
+/*!
+  \return false if the file could not be written.
+*/
+bool writeMidiFile( const std::string &fileName, const Timeline &timeline, const TempoMap &tempo );
+
+#endif
@@ -0,0 +1,219 @@
+//*******************************************************************************************//
+//  Playback.cpp
+//
+//  Implementation of the DeadlineScheduler (see Playback.h).
+//*******************************************************************************************//
+
+#include "Playback.h"
+#include "MeasureStream.h"
+
+// Platform-dependent monotonic clock and sleep routines.
+#if defined(__WINDOWS_MM__)
+  #include <windows.h>
+#else // Unix variants
+  #include <time.h>
+  #include <errno.h>
+#endif
+
+DeadlineScheduler :: DeadlineScheduler( double lateToleranceMs )
+  : pacing_( ABSOLUTE_DEADLINE ), spinTime_( 200000 ), startTime_( 0 ), lateTolerance_( (long long) (lateToleranceMs * 1000000.0) ), dueTime_( 0 ),
+    waits_( 0 ), lateWaits_( 0 ), maxLateness_( 0 ), totalLateness_( 0 ), lastLateness_( 0 )
+{
+}
+
+void DeadlineScheduler :: setPacing( Pacing pacing, double spinMs )
+{
+  pacing_ = pacing;
+  spinTime_ = (long long) (spinMs * 1000000.0);
+}
+
+void DeadlineScheduler :: start( void )
+{
+  startTime_ = now();
+  dueTime_ = 0;
+  waits_ = 0;
+  lateWaits_ = 0;
+  maxLateness_ = 0;
+  totalLateness_ = 0;
+  lastLateness_ = 0;
+}
+
+void DeadlineScheduler :: waitUntil( double dueMs )
+{
+  waitUntilTime( (long long) (dueMs * 1000000.0) );
+}
+
+void DeadlineScheduler :: waitUntilTime( long long dueTime )
+{
+  long long deadline = startTime_ + dueTime;
+  switch ( pacing_ ) {
+  case RELATIVE_SLEEP:
+    // Sleep for the delta between the deadlines, whenever this step began.
+    sleepUntil( now() + ( dueTime - dueTime_ ) );
+    break;
+  case SPIN_ASSISTED:
+    sleepUntil( deadline - spinTime_ );
+    while ( now() < deadline ) {}
+    break;
+  default:
+    sleepUntil( deadline );
+  }
+  dueTime_ = dueTime;
+
+  // Record how late we woke up with respect to the deadline.
+  long long lateness = now() - deadline;
+  if ( lateness < 0 ) lateness = 0;
+  waits_++;
+  totalLateness_ += lateness;
+  lastLateness_ = lateness;
+  if ( lateness > maxLateness_ ) maxLateness_ = lateness;
+  if ( lateness > lateTolerance_ ) lateWaits_++;
+}
+
+void DeadlineScheduler :: waitNext( double deltaMs )
+{
+  waitUntilTime( dueTime_ + (long long) (deltaMs * 1000000.0) );
+}
+
+double DeadlineScheduler :: getElapsedTime( void ) const
+{
+  return ( now() - startTime_ ) * 0.000001;
+}
+
+void DeadlineScheduler :: printReport( std::ostream &os ) const
+{
+  os << "\nPlayback timing report:\n";
+  os << "  deadlines:     " << waits_ << '\n';
+  os << "  late (> " << lateTolerance_ * 0.000001 << " ms): " << lateWaits_ << '\n';
+  if ( waits_ > 0 )
+    os << "  mean lateness: " << ( totalLateness_ / (double) waits_ ) * 0.000001 << " ms\n";
+  os << "  max lateness:  " << maxLateness_ * 0.000001 << " ms\n";
+  os << "  final drift:   " << lastLateness_ * 0.000001 << " ms (at " << getDueTime() << " ms)\n";
+}
+
+void playTimeline( RtMidiOut *midiout, const Timeline &timeline, const TempoMap &tempo,
+                   DeadlineScheduler &scheduler, VoiceTracker &voices )
+{
+  const std::vector<MidiEvent> &events = timeline.events;
+  unsigned long i = 0, nEvents = events.size();
+  unsigned int segment = 0;
+
+  scheduler.start();
+  while ( i < nEvents ) {
+    // All notes that should begin (or end) at the same time:
+    unsigned long tick = events[i].tick;
+    scheduler.waitUntilTime( tempo.getTime( tick, segment ) );
+    for ( ; i < nEvents && events[i].tick == tick; i++ )
+      voices.add( events[i] );
+    voices.sendGroup( midiout );
+  }
+  scheduler.waitUntilTime( tempo.getTime( timeline.length, segment ) );
+}
+
+void playStream( RtMidiOut *midiout, MeasureStream &stream, const TempoMap &tempo,
+                 DeadlineScheduler &scheduler, VoiceTracker &voices )
+{
+  const Timeline *measure = stream.front();
+  unsigned long length = 0;
+  unsigned int segment = 0;
+
+  scheduler.start();
+  for ( ; measure != 0; measure = stream.front() ) {
+    const std::vector<MidiEvent> &events = measure->events;
+    unsigned long i = 0, nEvents = events.size();
+    while ( i < nEvents ) {
+      if ( stream.isCancelled() ) return;
+      unsigned long tick = events[i].tick;
+      scheduler.waitUntilTime( tempo.getTime( tick, segment ) );
+      for ( ; i < nEvents && events[i].tick == tick; i++ )
+        voices.add( events[i] );
+      voices.sendGroup( midiout );
+    }
+    length = measure->length;
+    stream.pop();
+  }
+  if ( !stream.isCancelled() ) scheduler.waitUntilTime( tempo.getTime( length, segment ) );
+}
+
+void playStreamAhead( RtMidiOut *midiout, MeasureStream &stream, const TempoMap &tempo,
+                      DeadlineScheduler &scheduler, VoiceTracker &voices, double aheadMs )
+{
+  const Timeline *measure = stream.front();
+  long long ahead = (long long) ( aheadMs * 1000000.0 );
+  long long lastDue = 0;
+  unsigned long length = 0;
+  unsigned int segment = 0;
+
+  // Time 0 of the piece is aheadMs from now on the output clock.
+  scheduler.start();
+  double origin = midiout->getOutputTime() + aheadMs * 0.001;
+  for ( ; measure != 0 && !stream.isCancelled(); measure = stream.front() ) {
+    // Submit the measure aheadMs before it starts.
+    scheduler.waitUntilTime( tempo.getTime( length, segment ) );
+
+    const std::vector<MidiEvent> &events = measure->events;
+    unsigned long i = 0, nEvents = events.size();
+    while ( i < nEvents ) {
+      unsigned long tick = events[i].tick;
+      lastDue = tempo.getTime( tick, segment );
+      for ( ; i < nEvents && events[i].tick == tick; i++ )
+        voices.add( events[i] );
+      voices.sendGroupAt( midiout, origin + lastDue * 0.000000001 );
+    }
+    length = measure->length;
+    stream.pop();
+  }
+  if ( !stream.isCancelled() ) lastDue = tempo.getTime( length, segment );
+
+  // Wait for the API to dispatch what was submitted.
+  scheduler.waitUntilTime( lastDue + ahead );
+}
+
+#if defined(__WINDOWS_MM__)
+
+long long DeadlineScheduler :: now( void )
+{
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency( &frequency );
+  QueryPerformanceCounter( &counter );
+  return (long long) ( counter.QuadPart * ( 1000000000.0 / frequency.QuadPart ) );
+}
+
+void DeadlineScheduler :: sleepUntil( long long deadline )
+{
+  long long remaining;
+  while ( ( remaining = deadline - now() ) > 0 )
+    Sleep( (DWORD) ( remaining / 1000000 ) );
+}
+
+#else // Unix variants
+
+long long DeadlineScheduler :: now( void )
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void DeadlineScheduler :: sleepUntil( long long deadline )
+{
+#if defined(__linux__)
+  // Sleep directly on the absolute deadline.
+  struct timespec ts;
+  ts.tv_sec = deadline / 1000000000LL;
+  ts.tv_nsec = deadline % 1000000000LL;
+  while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL ) == EINTR ) {}
+#else
+  // No absolute sleep available (OS-X): sleep for whatever remains
+  // until the deadline, re-reading the clock after each wake-up.
+  long long remaining;
+  while ( ( remaining = deadline - now() ) > 0 ) {
+    struct timespec ts;
+    ts.tv_sec = remaining / 1000000000LL;
+    ts.tv_nsec = remaining % 1000000000LL;
+    nanosleep( &ts, NULL );
+  }
+#endif
+}
+
+#endif
@@ -0,0 +1,151 @@
+//*******************************************************************************************//
+//  Playback.h
+//
+//  Timing support for the programs that play generated pieces in real time.
+//
+//  DeadlineScheduler paces a piece against absolute due times measured from
+//  the start of the piece on a monotonic clock.  Every step waits until its
+//  own deadline instead of sleeping for a relative delta, so the time spent
+//  generating and sending MIDI messages never accumulates as drift.  The
+//  scheduler also keeps track of how late each wake-up was, so that a run
+//  can report its timing accuracy once the piece is over.  Deadlines are
+//  integer nanoseconds, as given by a TempoMap.  The pacing can also be
+//  switched to the old relative sleeps, or to a sleep that ends shortly
+//  before the deadline followed by a spin on the clock, so the strategies
+//  can be compared (see midibench.cpp).
+//
+//  playTimeline() plays a compiled Timeline with a linear scan of its
+//  events, waiting once for every distinct tick.  playStream() does the
+//  same with the measures of a MeasureStream as they are generated.  Both
+//  send the events through a VoiceTracker, which caps the polyphony, and
+//  send all the events of a tick (e.g. a chord) as a single group.
+//  playStreamAhead() instead hands each measure to the MIDI API ahead of
+//  time, every event stamped with its due time, so the notes are
+//  dispatched by the API's own clock (the ALSA sequencer queue, or the
+//  frames of the JACK cycle).
+//*******************************************************************************************//
+
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <iostream>
+#include "RtMidi.h"
+#include "TempoMap.h"
+#include "Timeline.h"
+#include "VoiceTracker.h"
+
+class MeasureStream;
+
+class DeadlineScheduler
+{
+ public:
+
+  //! How a wait reaches its deadline.
+  enum Pacing {
+    RELATIVE_SLEEP,     /*!< Sleep for the time between the previous deadline and this one (drifts). */
+    ABSOLUTE_DEADLINE,  /*!< Sleep until the absolute deadline (the default). */
+    SPIN_ASSISTED       /*!< Sleep until shortly before the deadline, then spin on the clock. */
+  };
+
+  //! The constructor.
+  /*!
+    \param lateToleranceMs A wake-up that happens more than this many
+                           milliseconds after its deadline is counted
+                           as a late event in the report.
+  */
+  DeadlineScheduler( double lateToleranceMs = 1.0 );
+
+  //! Sets the pacing of the waits, \e spinMs being the spinning time of SPIN_ASSISTED.
+  void setPacing( Pacing pacing, double spinMs = 0.2 );
+
+  //! Returns the pacing of the waits.
+  Pacing getPacing( void ) const { return pacing_; }
+
+  //! Anchors the piece start (time 0) at the current monotonic time.
+  void start( void );
+
+  //! Returns the monotonic time of the piece start, in nanoseconds.
+  long long getStartTime( void ) const { return startTime_; }
+
+  //! Blocks until \e dueMs milliseconds after the piece start.
+  /*!
+    If the deadline has already passed, the function returns
+    immediately and the lateness is recorded.
+  */
+  void waitUntil( double dueMs );
+
+  //! Blocks until \e dueTime nanoseconds after the piece start.
+  void waitUntilTime( long long dueTime );
+
+  //! Moves the next deadline \e deltaMs milliseconds forward and blocks until it.
+  /*!
+    This is the absolute-time replacement for sleeping \e deltaMs
+    after each step: the deadline is computed from the piece start,
+    not from the moment the previous step finished.
+  */
+  void waitNext( double deltaMs );
+
+  //! Returns the deadline of the last wait, in milliseconds from the piece start.
+  double getDueTime( void ) const { return dueTime_ * 0.000001; }
+
+  //! Returns the milliseconds elapsed since the piece start.
+  double getElapsedTime( void ) const;
+
+  //! Prints the drift and late event statistics of the run.
+  void printReport( std::ostream &os = std::cout ) const;
+
+  //! Returns the current monotonic time in nanoseconds.
+  static long long now( void );
+
+  //! Blocks until the monotonic clock reaches \e deadline (nanoseconds).
+  static void sleepUntil( long long deadline );
+
+ protected:
+  Pacing pacing_;
+  long long spinTime_;
+  long long startTime_;
+  long long lateTolerance_;
+  long long dueTime_;  // nanoseconds from the piece start
+
+  // Lateness statistics, in nanoseconds.
+  unsigned long waits_;
+  unsigned long lateWaits_;
+  long long maxLateness_;
+  long long totalLateness_;
+  long long lastLateness_;
+};
+
+//! Plays \e timeline through \e midiout in real time.
+/*!
+  The scheduler is started at the first event.  All events sharing a
+  tick are sent together once that tick's deadline is reached and the
+  function returns at the end of the piece (after its last tick).
+*/
+void playTimeline( RtMidiOut *midiout, const Timeline &timeline, const TempoMap &tempo,
+                   DeadlineScheduler &scheduler, VoiceTracker &voices );
+
+//! Plays the measures of \e stream through \e midiout in real time, as they are generated.
+/*!
+  The scheduler is started as soon as the first measure is available,
+  and each measure is handed back to the generator once it has been
+  sent.  The function returns at the end of the last measure, or at
+  the next tick once the stream is cancelled.  Notes may then still be
+  sounding: see VoiceTracker::flush().
+*/
+void playStream( RtMidiOut *midiout, MeasureStream &stream, const TempoMap &tempo,
+                 DeadlineScheduler &scheduler, VoiceTracker &voices );
+
+//! Plays the measures of \e stream through \e midiout, scheduling each one on the output clock ahead of time.
+/*!
+  Each measure is submitted \e aheadMs milliseconds before it starts,
+  with every event stamped with its due time (see
+  RtMidiOut::sendMessageAt()), so the scheduler only paces the
+  submissions.  The function returns once every submitted event is due,
+  at the end of the piece or soon after the stream is cancelled.  With
+  an API that does not schedule output, the events of a measure are
+  sent at once.
+*/
+void playStreamAhead( RtMidiOut *midiout, MeasureStream &stream, const TempoMap &tempo,
+                      DeadlineScheduler &scheduler, VoiceTracker &voices, double aheadMs );
+
+#endif
@@ -0,0 +1,50 @@
+//*******************************************************************************************//
+//  RandomEngine.h
+//
+//  A small, explicitly seeded pseudo-random number engine (SplitMix64).
+//
+//  Unlike srandomdev()/random(), every engine object has its own state:
+//  there is no global lock, any number of engines can be used from
+//  different threads, and the same seed always gives the same sequence
+//  on every platform.
+//*******************************************************************************************//
+
+#ifndef RANDOMENGINE_H
+#define RANDOMENGINE_H
+
+class RandomEngine
+{
+ public:
+
+  //! The constructor.
+  RandomEngine( unsigned long long seed = 1 ) : state_( seed ) {}
+
+  //! Restarts the sequence from \e seed.
+  void setSeed( unsigned long long seed ) { state_ = seed; }
+
+  //! Returns the next 64 random bits.
+  unsigned long long next( void )
+  {
+    unsigned long long z = ( state_ += 0x9E3779B97F4A7C15ULL );
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+  }
+
+  //! Returns a random integer between 0 and \e n - 1.
+  unsigned int nextInt( unsigned int n )
+  {
+    return (unsigned int) ( ( ( next() >> 32 ) * n ) >> 32 );
+  }
+
+  //! Returns a random number in [0, 1).
+  double nextDouble( void )
+  {
+    return ( next() >> 11 ) * ( 1.0 / 9007199254740992.0 );
+  }
+
+ protected:
+  unsigned long long state_;
+};
+
+#endif
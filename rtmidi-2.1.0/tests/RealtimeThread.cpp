@@ -0,0 +1,120 @@
+//*******************************************************************************************//
+//  RealtimeThread.cpp
+//
+//  Implementation of the RealtimeThread (see RealtimeThread.h).
+//*******************************************************************************************//
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE  // for pthread_setaffinity_np()
+#endif
+
+#include "RealtimeThread.h"
+
+#if !defined(__WINDOWS_MM__)
+  #include <sched.h>
+  #include <sys/mman.h>
+#endif
+
+// Stack touched by the thread before it runs the sender.
+const unsigned int PREFAULT_STACK_BYTES = 256 * 1024;
+
+// Stack of the thread.  With the memory locked, the whole stack is
+// locked as soon as it is mapped and counts against RLIMIT_MEMLOCK, so
+// it is kept well below the usual 8 MB default.
+const size_t THREAD_STACK_BYTES = 1024 * 1024;
+
+// Writes to every page of PREFAULT_STACK_BYTES of stack below the caller.
+static unsigned char prefaultStack( void )
+{
+  volatile unsigned char stack[PREFAULT_STACK_BYTES];
+  for ( unsigned int i = 0; i < PREFAULT_STACK_BYTES; i += 1024 )
+    stack[i] = 0;
+  return stack[0];
+}
+
+RealtimeThread :: RealtimeThread( void )
+  : priority_( 0 ), cpu_( -1 ), lockMemory_( false ), fifo_( false ), pinned_( false ),
+    locked_( false ), unlocked_( false ), function_( 0 ), arg_( 0 )
+{
+}
+
+bool RealtimeThread :: run( void *(*function)( void * ), void *arg )
+{
+  function_ = function;
+  arg_ = arg;
+  fifo_ = false;
+  pinned_ = false;
+  locked_ = false;
+  unlocked_ = false;
+
+#if !defined(__WINDOWS_MM__)
+  // Lock whatever is mapped now (the preallocated buffers included) and
+  // whatever gets mapped later, so the playback never waits on a page fault.
+  if ( lockMemory_ ) locked_ = ( mlockall( MCL_CURRENT | MCL_FUTURE ) == 0 );
+#endif
+
+  pthread_attr_t attributes;
+  pthread_attr_init( &attributes );
+  pthread_attr_setstacksize( &attributes, THREAD_STACK_BYTES );
+
+  pthread_t thread;
+  int result = pthread_create( &thread, &attributes, threadEntry, this );
+#if !defined(__WINDOWS_MM__)
+  // The stack may still not fit under the locking limit: run unlocked.
+  if ( result != 0 && locked_ ) {
+    munlockall();
+    locked_ = false;
+    unlocked_ = true;
+    result = pthread_create( &thread, &attributes, threadEntry, this );
+  }
+#endif
+  pthread_attr_destroy( &attributes );
+  if ( result != 0 ) return false;
+  pthread_join( thread, NULL );
+  return true;
+}
+
+void *RealtimeThread :: threadEntry( void *ptr )
+{
+  RealtimeThread *thread = static_cast<RealtimeThread *> (ptr);
+
+#if !defined(__WINDOWS_MM__)
+  if ( thread->priority_ > 0 ) {
+    struct sched_param param;
+    param.sched_priority = thread->priority_;
+    thread->fifo_ = ( pthread_setschedparam( pthread_self(), SCHED_FIFO, &param ) == 0 );
+  }
+#endif
+
+#if defined(__linux__)
+  if ( thread->cpu_ >= 0 && thread->cpu_ < CPU_SETSIZE ) {
+    cpu_set_t cpus;
+    CPU_ZERO( &cpus );
+    CPU_SET( thread->cpu_, &cpus );
+    thread->pinned_ = ( pthread_setaffinity_np( pthread_self(), sizeof(cpus), &cpus ) == 0 );
+  }
+#endif
+
+  prefaultStack();
+  return thread->function_( thread->arg_ );
+}
+
+void RealtimeThread :: printReport( std::ostream &os ) const
+{
+  os << "\nReal-time playback thread:\n";
+  os << "  scheduling:    ";
+  if ( priority_ <= 0 ) os << "normal\n";
+  else if ( fifo_ ) os << "SCHED_FIFO, priority " << priority_ << '\n';
+  else os << "normal (SCHED_FIFO priority " << priority_ << " was denied)\n";
+
+  os << "  CPU:           ";
+  if ( cpu_ < 0 ) os << "any\n";
+  else if ( pinned_ ) os << cpu_ << '\n';
+  else os << "any (pinning to CPU " << cpu_ << " was denied)\n";
+
+  os << "  memory:        ";
+  if ( !lockMemory_ ) os << "not locked\n";
+  else if ( locked_ ) os << "locked\n";
+  else if ( unlocked_ ) os << "not locked (the thread stack did not fit under the locking limit)\n";
+  else os << "not locked (mlockall was denied)\n";
+}
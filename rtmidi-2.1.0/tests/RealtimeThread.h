@@ -0,0 +1,78 @@
+//*******************************************************************************************//
+//  RealtimeThread.h
+//
+//  Runs the sender of a piece on a dedicated thread set up for real-time
+//  playback.
+//
+//  Each setting is optional: the thread can be given a SCHED_FIFO
+//  priority, pinned to a CPU, and the process memory locked with mlockall()
+//  so that no page fault can stall a note once the piece has started.  The
+//  thread has a small stack of its own, which it touches before running
+//  the sender, so the stack pages are faulted in (and locked) in
+//  advance.  A setting the system refuses (typically for lack of
+//  privileges) is not an error: the thread runs without it, and the
+//  report tells which settings were applied.
+//*******************************************************************************************//
+
+#ifndef REALTIMETHREAD_H
+#define REALTIMETHREAD_H
+
+#include <iostream>
+#include <pthread.h>
+
+class RealtimeThread
+{
+ public:
+
+  //! The constructor: normal scheduling, any CPU, memory not locked.
+  RealtimeThread( void );
+
+  //! Sets the SCHED_FIFO priority of the thread (0 for the normal scheduling).
+  void setPriority( int priority ) { priority_ = priority; }
+
+  //! Sets the CPU the thread is pinned to (-1 for any CPU, Linux only).
+  void setCpu( int cpu ) { cpu_ = cpu; }
+
+  //! Locks all the current and future memory of the process before running the thread.
+  void setLockMemory( bool lockMemory ) { lockMemory_ = lockMemory; }
+
+  //! Runs \e function( \e arg ) on a new thread with the settings and waits for it to return.
+  /*!
+    Returns false if the thread could not be created at all.
+  */
+  bool run( void *(*function)( void * ), void *arg );
+
+  //! Returns true if the thread ran with its SCHED_FIFO priority.
+  bool isFifo( void ) const { return fifo_; }
+
+  //! Returns true if the thread ran pinned to its CPU.
+  bool isPinned( void ) const { return pinned_; }
+
+  //! Returns true if the process memory was locked.
+  /*!
+    If the thread could not be created with the memory locked (its
+    stack counts against RLIMIT_MEMLOCK), the memory is unlocked again
+    and the thread runs without it.
+  */
+  bool isLocked( void ) const { return locked_; }
+
+  //! Prints the settings asked for and the ones actually applied.
+  void printReport( std::ostream &os = std::cout ) const;
+
+ protected:
+  static void *threadEntry( void *ptr );
+
+  int priority_;
+  int cpu_;
+  bool lockMemory_;
+
+  bool fifo_;
+  bool pinned_;
+  bool locked_;
+  bool unlocked_;  // locked, then unlocked to create the thread
+
+  void *(*function_)( void * );
+  void *arg_;
+};
+
+#endif
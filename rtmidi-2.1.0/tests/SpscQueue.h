@@ -0,0 +1,78 @@
+//*******************************************************************************************//
+//  SpscQueue.h
+//
+//  A bounded, lock-free queue between exactly one producer thread and one
+//  consumer thread.
+//
+//  The N slots are allocated once with the queue and are written and read
+//  in place: the producer fills the slot returned by writeSlot() and
+//  publishes it with commitWrite(), the consumer reads the slot returned by
+//  readSlot() and hands it back with commitRead().  Neither side ever
+//  blocks, allocates or takes a lock, so the consumer can be a real-time
+//  thread.
+//*******************************************************************************************//
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+
+template <class T, unsigned int N>
+class SpscQueue
+{
+  static_assert( N > 0 && ( N & ( N - 1 ) ) == 0, "queue capacity must be a power of 2" );
+
+ public:
+
+  //! Number of slots of the queue.
+  static const unsigned int CAPACITY = N;
+
+  //! The constructor.
+  SpscQueue( void ) : head_( 0 ), tail_( 0 ) {}
+
+  //! Producer: returns the next free slot, or 0 if the queue is full.
+  T *writeSlot( void )
+  {
+    unsigned int tail = tail_.load( std::memory_order_relaxed );
+    if ( tail - head_.load( std::memory_order_acquire ) == N ) return 0;
+    return &slots_[tail & ( N - 1 )];
+  }
+
+  //! Producer: publishes the slot returned by writeSlot().
+  void commitWrite( void )
+  {
+    tail_.store( tail_.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+  }
+
+  //! Consumer: returns the oldest published slot, or 0 if the queue is empty.
+  T *readSlot( void )
+  {
+    unsigned int head = head_.load( std::memory_order_relaxed );
+    if ( tail_.load( std::memory_order_acquire ) == head ) return 0;
+    return &slots_[head & ( N - 1 )];
+  }
+
+  //! Consumer: releases the slot returned by readSlot() to the producer.
+  void commitRead( void )
+  {
+    head_.store( head_.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+  }
+
+  //! Returns the number of published slots (only exact from either thread's own side).
+  unsigned int size( void ) const
+  {
+    return tail_.load( std::memory_order_acquire ) - head_.load( std::memory_order_acquire );
+  }
+
+  //! Gives direct access to a slot, e.g. to preallocate its storage before use.
+  T &slot( unsigned int i ) { return slots_[i & ( N - 1 )]; }
+
+ protected:
+  T slots_[N];
+
+  // Each index is written by one side only; keep them on separate cache lines.
+  alignas(64) std::atomic<unsigned int> head_;  // next slot to read
+  alignas(64) std::atomic<unsigned int> tail_;  // next slot to write
+};
+
+#endif
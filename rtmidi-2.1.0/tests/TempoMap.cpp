@@ -0,0 +1,94 @@
+//*******************************************************************************************//
+//  TempoMap.cpp
+//
+//  Implementation of the TempoMap (see TempoMap.h).
+//*******************************************************************************************//
+
+#include "TempoMap.h"
+
+TempoMap :: TempoMap( long long tickDuration )
+{
+  reset( tickDuration );
+}
+
+void TempoMap :: reset( long long tickDuration )
+{
+  Segment segment;
+  segment.tick = 0;
+  segment.time = 0;
+  segment.tickDuration = ( tickDuration > 0 ) ? tickDuration : 1;
+  segments_.assign( 1, segment );
+}
+
+void TempoMap :: setTempo( unsigned long tick, long long tickDuration )
+{
+  if ( tickDuration <= 0 ) tickDuration = 1;
+
+  // Drop the changes from tick on.
+  while ( segments_.size() > 1 && segments_.back().tick >= tick ) segments_.pop_back();
+  if ( tick == 0 ) {
+    segments_[0].tickDuration = tickDuration;
+    return;
+  }
+
+  const Segment &last = segments_.back();
+  if ( last.tickDuration == tickDuration ) return;
+
+  Segment segment;
+  segment.tick = tick;
+  segment.time = last.time + (long long) ( tick - last.tick ) * last.tickDuration;
+  segment.tickDuration = tickDuration;
+  segments_.push_back( segment );
+}
+
+void TempoMap :: rampTempo( unsigned long startTick, unsigned long endTick,
+                            long long startDuration, long long endDuration )
+{
+  if ( endTick > startTick ) {
+    long long nTicks = (long long) ( endTick - startTick );
+    for ( unsigned long tick = startTick; tick < endTick; tick++ ) {
+      long long step = (long long) ( tick - startTick );
+      setTempo( tick, startDuration + ( endDuration - startDuration ) * step / nTicks );
+    }
+  }
+  setTempo( endTick, endDuration );
+}
+
+unsigned int TempoMap :: findSegment( unsigned long tick ) const
+{
+  // Last segment starting at or before tick.
+  unsigned int low = 0, high = segments_.size();
+  while ( high - low > 1 ) {
+    unsigned int middle = ( low + high ) / 2;
+    if ( segments_[middle].tick <= tick ) low = middle;
+    else high = middle;
+  }
+  return low;
+}
+
+long long TempoMap :: getTime( unsigned long tick ) const
+{
+  const Segment &segment = segments_[findSegment( tick )];
+  return segment.time + (long long) ( tick - segment.tick ) * segment.tickDuration;
+}
+
+long long TempoMap :: getTime( unsigned long tick, unsigned int &segment ) const
+{
+  if ( segment >= segments_.size() || segments_[segment].tick > tick )
+    segment = findSegment( tick );
+  while ( segment + 1 < segments_.size() && segments_[segment + 1].tick <= tick ) segment++;
+
+  const Segment &current = segments_[segment];
+  return current.time + (long long) ( tick - current.tick ) * current.tickDuration;
+}
+
+long long TempoMap :: getTickDuration( unsigned long tick ) const
+{
+  return segments_[findSegment( tick )].tickDuration;
+}
+
+long long TempoMap :: bpmToTickDuration( double bpm )
+{
+  if ( bpm <= 0.0 ) return DEFAULT_TICK_NS;
+  return (long long) ( 60000000000.0 / ( bpm * TICKS_PER_QUARTER ) + 0.5 );
+}
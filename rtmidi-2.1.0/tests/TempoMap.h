@@ -0,0 +1,84 @@
+//*******************************************************************************************//
+//  TempoMap.h
+//
+//  Converts the integer ticks of a Timeline to time.
+//
+//  The map is a list of segments, each starting at a tick with its own
+//  tick duration in integer nanoseconds.  Each segment also stores the
+//  time of its first tick: these prefix sums are computed once, when the
+//  tempo is set, so converting a tick to time is a lookup, one multiply
+//  and one add, and a tempo change or an accelerando costs nothing per
+//  event.  The durations are exact integers, so no rounding can accumulate
+//  over a piece.
+//*******************************************************************************************//
+
+#ifndef TEMPOMAP_H
+#define TEMPOMAP_H
+
+#include <vector>
+#include "Timeline.h"
+
+class TempoMap
+{
+ public:
+
+  //! A span of ticks with the same duration.
+  struct Segment {
+    unsigned long tick;      // first tick of the segment
+    long long time;          // time of that tick from tick 0, in nanoseconds
+    long long tickDuration;  // in nanoseconds
+  };
+
+  //! The constructor sets a single tempo for the whole piece.
+  TempoMap( long long tickDuration = DEFAULT_TICK_NS );
+
+  //! Removes every tempo change and sets a single tempo for the whole piece.
+  void reset( long long tickDuration );
+
+  //! Sets the duration of all ticks from \e tick on.
+  /*!
+    Any tempo change after \e tick is removed, so a map is built from
+    the first change to the last.
+  */
+  void setTempo( unsigned long tick, long long tickDuration );
+
+  //! Changes the tick duration linearly, tick by tick, from \e startTick to \e endTick.
+  /*!
+    Ticks from \e startTick to \e endTick - 1 go from \e startDuration
+    towards \e endDuration (an accelerando if it is shorter, a
+    ritardando if it is longer) and the ticks from \e endTick on last \e
+    endDuration.  Later tempo changes are removed.
+  */
+  void rampTempo( unsigned long startTick, unsigned long endTick,
+                  long long startDuration, long long endDuration );
+
+  //! Returns the time of \e tick from tick 0, in nanoseconds (a binary search).
+  long long getTime( unsigned long tick ) const;
+
+  //! Returns the time of \e tick, starting the search at segment \e segment.
+  /*!
+    \e segment is updated to the segment of \e tick, so when the ticks
+    only go forward (as when a piece is played) the lookup takes
+    constant time.  Start with \e segment = 0.
+  */
+  long long getTime( unsigned long tick, unsigned int &segment ) const;
+
+  //! Returns the duration of \e tick, in nanoseconds.
+  long long getTickDuration( unsigned long tick ) const;
+
+  //! Returns the number of segments (at least 1).
+  unsigned int getSegmentCount( void ) const { return segments_.size(); }
+
+  //! Returns segment \e i, in tick order.
+  const Segment& getSegment( unsigned int i ) const { return segments_[i]; }
+
+  //! Returns the tick duration giving \e bpm quarter notes per minute.
+  static long long bpmToTickDuration( double bpm );
+
+ protected:
+  unsigned int findSegment( unsigned long tick ) const;
+
+  std::vector<Segment> segments_;
+};
+
+#endif
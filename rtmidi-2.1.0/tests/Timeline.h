@@ -0,0 +1,45 @@
+//*******************************************************************************************//
+//  Timeline.h
+//
+//  The compiled form of a generated piece: a single contiguous array of
+//  MIDI events sorted by tick.  It is built once by the generator and then
+//  consumed by a linear scan, whether the piece is played in real time or
+//  written to a file.  Ticks are integers at TICKS_PER_QUARTER per quarter
+//  note, so triplets are exact; a TempoMap turns them into time.
+//*******************************************************************************************//
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <vector>
+
+// The tick is the smallest rhythmic unit of the piece: one note of an
+// eighth-note triplet.  The eighth note is therefore 3 ticks long and a
+// measure of 8 eighth notes is 24 ticks long.
+const unsigned int TICKS_PER_EIGHTH = 3;
+const unsigned int TICKS_PER_QUARTER = 2 * TICKS_PER_EIGHTH;
+const unsigned int TICKS_PER_MEASURE = 8 * TICKS_PER_EIGHTH;
+
+// Default tick duration, in nanoseconds: an eighth note of 249 ms.
+const long long DEFAULT_TICK_NS = 249000000LL / TICKS_PER_EIGHTH;
+
+// A single channel message of the piece.
+struct MidiEvent {
+  unsigned long tick;
+  unsigned char status;
+  unsigned char note;
+  unsigned char velocity;
+};
+
+struct Timeline {
+  std::vector<MidiEvent> events;  // sorted by tick
+  unsigned long length;           // total length of the piece, in ticks
+
+  // Default constructor.
+  Timeline()
+  :length(0) {}
+
+  void clear( void ) { events.clear(); length = 0; }
+};
+
+#endif
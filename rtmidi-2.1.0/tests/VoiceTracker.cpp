@@ -0,0 +1,117 @@
+//*******************************************************************************************//
+//  VoiceTracker.cpp
+//
+//  Implementation of the VoiceTracker (see VoiceTracker.h).
+//*******************************************************************************************//
+
+#include "VoiceTracker.h"
+
+VoiceTracker :: VoiceTracker( unsigned int maxVoices )
+  : maxVoices_( 1 ), nActive_( 0 ), stolen_( 0 ), nNoteOns_( 0 )
+{
+  setMaxVoices( maxVoices );
+  for ( unsigned int i = 0; i < 128; i++ ) {
+    started_[i] = 0;
+    struck_[i] = released_[i] = sounding_[i] = 0;
+  }
+
+  // Room for a large chord (and its stolen notes) without reallocating,
+  // its pages faulted in before the first note.
+  group_.resize( 3 * 64 );
+  group_.clear();
+}
+
+void VoiceTracker :: setMaxVoices( unsigned int maxVoices )
+{
+  maxVoices_ = ( maxVoices > 0 ) ? maxVoices : 1;
+}
+
+void VoiceTracker :: add( const MidiEvent &event )
+{
+  unsigned char type = event.status & 0xF0;
+  unsigned char note = event.note & 0x7F;
+
+  if ( type == 0x90 && event.velocity > 0 ) {
+    if ( started_[note] == 0 ) {
+      if ( nActive_ >= maxVoices_ ) {
+        // Steal the oldest sounding note.
+        unsigned int oldest = 0;
+        for ( unsigned int i = 1; i < 128; i++ )
+          if ( started_[i] != 0 && ( started_[oldest] == 0 || started_[i] < started_[oldest] ) )
+            oldest = i;
+        noteOff( (unsigned char) oldest );
+        stolen_++;
+      }
+      nActive_++;
+    }
+    // Struck again while sounding, the note becomes the new instance
+    // and the NoteOff of the previous one will be dropped.
+    started_[note] = ++nNoteOns_;
+    sounding_[note] = ++struck_[note];
+  }
+  else if ( type == 0x80 || type == 0x90 ) {
+    // A NoteOff without a NoteOn left to release is ignored.
+    if ( released_[note] == struck_[note] ) return;
+    // The NoteOff of an instance already stolen or struck again.
+    if ( ++released_[note] != sounding_[note] ) return;
+    started_[note] = 0;
+    sounding_[note] = 0;
+    nActive_--;
+  }
+
+  group_.push_back( event.status );
+  group_.push_back( event.note );
+  group_.push_back( event.velocity );
+}
+
+void VoiceTracker :: sendGroup( RtMidiOut *midiout )
+{
+  if ( group_.empty() ) return;
+  midiout->sendMessages( &group_ );
+  group_.clear();
+}
+
+void VoiceTracker :: sendGroupAt( RtMidiOut *midiout, double timeStamp )
+{
+  // The group only holds 3-byte messages.
+  for ( unsigned int i = 0; i + 2 < group_.size(); i += 3 )
+    midiout->sendMessageAt( timeStamp, &group_[i], 3 );
+  group_.clear();
+}
+
+bool VoiceTracker :: sendGroup( RtMidiOutQueue *queue )
+{
+  bool pushed = true;
+  for ( unsigned int i = 0; i + 2 < group_.size(); i += 3 )
+    if ( queue->push( &group_[i], 3 ) == false ) pushed = false;
+  group_.clear();
+  return pushed;
+}
+
+void VoiceTracker :: flush( RtMidiOut *midiout )
+{
+  releaseAll();
+  sendGroup( midiout );
+}
+
+bool VoiceTracker :: flush( RtMidiOutQueue *queue )
+{
+  releaseAll();
+  return sendGroup( queue );
+}
+
+void VoiceTracker :: releaseAll( void )
+{
+  for ( unsigned int i = 0; i < 128; i++ )
+    if ( started_[i] != 0 ) noteOff( (unsigned char) i );
+}
+
+void VoiceTracker :: noteOff( unsigned char note )
+{
+  group_.push_back( 144 );  // with velocity 0
+  group_.push_back( note );
+  group_.push_back( 0 );
+  started_[note] = 0;
+  sounding_[note] = 0;
+  nActive_--;
+}
@@ -0,0 +1,108 @@
+//*******************************************************************************************//
+//  VoiceTracker.h
+//
+//  Keeps track of the notes sounding on the synthesizer while a piece is
+//  played (on a single channel), and caps their number.
+//
+//  Every event of the piece goes through add(), which appends it to the
+//  group of events sharing its tick, and sendGroup() then sends the group
+//  with a single RtMidiOut::sendMessages() call.  When a NoteOn would
+//  exceed the polyphony ceiling, the oldest sounding note is released
+//  first (the choice only depends on the order of the NoteOns, so a piece
+//  always steals the same voices).  The NoteOns of a key are numbered,
+//  and the NoteOffs of the piece are matched to them in order, so the
+//  scheduled NoteOff of an instance that was stolen, or struck again
+//  while still sounding, is dropped instead of cutting the instance now
+//  sounding short.  flush() releases every note still sounding, e.g. when
+//  the program is interrupted.
+//*******************************************************************************************//
+
+#ifndef VOICETRACKER_H
+#define VOICETRACKER_H
+
+#include <vector>
+#include "RtMidi.h"
+#include "Timeline.h"
+
+class VoiceTracker
+{
+ public:
+
+  //! Default polyphony ceiling.
+  static const unsigned int DEFAULT_MAX_VOICES = 16;
+
+  //! The constructor.
+  /*!
+    \param maxVoices The largest number of notes sounding at the same
+                     time (at least 1).
+  */
+  VoiceTracker( unsigned int maxVoices = DEFAULT_MAX_VOICES );
+
+  //! Sets the polyphony ceiling (at least 1), for the next NoteOns.
+  void setMaxVoices( unsigned int maxVoices );
+
+  //! Returns the polyphony ceiling.
+  unsigned int getMaxVoices( void ) const { return maxVoices_; }
+
+  //! Returns the number of notes sounding.
+  unsigned int getActiveVoices( void ) const { return nActive_; }
+
+  //! Returns the number of notes released early to respect the ceiling.
+  unsigned long getStolenVoices( void ) const { return stolen_; }
+
+  //! Adds \e event to the current group, keeping track of the sounding notes.
+  /*!
+    A NoteOn over the ceiling is preceded in the group by the NoteOff
+    of the stolen note.  A NoteOff is matched to the earliest NoteOn of
+    its key not yet released, and is left out unless that instance is
+    the one sounding.
+  */
+  void add( const MidiEvent &event );
+
+  //! Sends the current group through \e midiout at once and starts a new one.
+  void sendGroup( RtMidiOut *midiout );
+
+  //! Schedules the current group through \e midiout at \e timeStamp seconds of its output clock and starts a new one.
+  /*!
+    See RtMidiOut::sendMessageAt().
+  */
+  void sendGroupAt( RtMidiOut *midiout, double timeStamp );
+
+  //! Pushes the messages of the current group to \e queue and starts a new one.
+  /*!
+    The messages are only sent when the queue is drained.  Returns
+    false if \e queue refused some of them (see RtMidiOutQueue::push()).
+  */
+  bool sendGroup( RtMidiOutQueue *queue );
+
+  //! Sends \e event alone through \e midiout, keeping track of the sounding notes.
+  void send( RtMidiOut *midiout, const MidiEvent &event ) { add( event ); sendGroup( midiout ); }
+
+  //! Sends a NoteOff for every note still sounding, as a single group.
+  void flush( RtMidiOut *midiout );
+
+  //! Pushes a NoteOff for every note still sounding to \e queue.
+  bool flush( RtMidiOutQueue *queue );
+
+ protected:
+  void noteOff( unsigned char note );
+  void releaseAll( void );
+
+  unsigned int maxVoices_;
+  unsigned int nActive_;
+  unsigned long stolen_;
+  unsigned long nNoteOns_;
+
+  // Per note: the order of its NoteOn, 0 if it is not sounding.
+  unsigned long started_[128];
+
+  // Per note: the NoteOns and NoteOffs of the piece so far, and the
+  // NoteOn (numbered from 1) sounding, 0 if none.
+  unsigned long struck_[128];
+  unsigned long released_[128];
+  unsigned long sounding_[128];
+
+  std::vector<unsigned char> group_;  // the messages of the current group, back to back
+};
+
+#endif
@@ -0,0 +1,122 @@
+//*******************************************************************************************//
+//  Voicings.h
+//
+//  Compile-time chord voicing tables of the Metamorphosis generator.
+//
+//  The generator only ever plays the 7 diatonic chords of a minor key in
+//  12 tonalities, each folded into one of a handful of register windows.
+//  All of these voicings are computed by the compiler into a constant
+//  table, already folded into their window and sorted from lowest to
+//  highest note, so looking a voicing up is a single indexed load.
+//*******************************************************************************************//
+
+#ifndef VOICINGS_H
+#define VOICINGS_H
+
+// The tables are built by loops in constexpr functions (C++14).
+#if __cplusplus < 201402L && !defined(_MSC_VER)
+  #error "Voicings.h needs C++14 (e.g. -std=c++14, as set by configure)."
+#endif
+
+const int TONALITIES = 12;
+const int CHORD_DEGREES = 7;
+
+//----------------------------------------//
+// ALL THE POSSIBLE CHORDS IN A MINOR KEY //
+//----------------------------------------//
+
+// Pitch classes of each chord (0 is the tonic of the key).
+constexpr int CHORDS_IN_KEY[CHORD_DEGREES][3] = {
+  {  0,  3,  7 },  // i    = {root = 0, mode = minor}
+  {  2,  5,  8 },  // ii-  = {root = 2, mode = diminished}
+  {  3,  7, 10 },  // III  = {root = 3, mode = Major}
+  {  5,  8,  0 },  // iv   = {root = 5, mode = minor}
+  {  7, 10,  2 },  // v    = {root = 7, mode = minor}
+  {  8,  0,  3 },  // VI   = {root = 8, mode = Major}
+  { 10,  2,  5 }   // VII  = {root = 10, mode = Major}
+};
+
+//! Register windows the chords are folded into.
+enum Register {
+  LEFT_HAND,      // C3 (48) to B3 (59), baseline A2 = 45
+  CHORD_HAND,     // C4 (60) to D5 (74), baseline A4 = 69
+  TRIPLET_HAND,   // F4 (65) to E5 (76), baseline A4 = 69
+  REGISTERS
+};
+
+struct RegisterWindow {
+  int baseline;  // note of the tonic of A (tonality 0)
+  int upperLimit;
+  int lowLimit;
+};
+
+constexpr RegisterWindow REGISTER_WINDOWS[REGISTERS] = {
+  { 45, 59, 48 },
+  { 69, 74, 60 },
+  { 69, 76, 65 }
+};
+
+//! The three notes of a chord, sorted from lowest to highest.
+struct Voicing {
+  unsigned char notes[3];
+};
+
+struct VoicingTable {
+  Voicing voicings[REGISTERS][TONALITIES][CHORD_DEGREES];
+};
+
+// Places the chord in its window (moving single notes by an octave)
+// and sorts it.
+constexpr Voicing makeVoicing( int window, int tonality, int degree )
+{
+  Voicing voicing = {};
+  int notes[3] = {};
+  for ( int i = 0; i < 3; i++ ) {
+    int note = CHORDS_IN_KEY[degree][i] + tonality + REGISTER_WINDOWS[window].baseline;
+    if ( note > REGISTER_WINDOWS[window].upperLimit ) note -= 12;
+    if ( note < REGISTER_WINDOWS[window].lowLimit ) note += 12;
+    notes[i] = note;
+  }
+  for ( int i = 1; i < 3; i++ ) {
+    for ( int j = i; j > 0 && notes[j-1] > notes[j]; j-- ) {
+      int note = notes[j];
+      notes[j] = notes[j-1];
+      notes[j-1] = note;
+    }
+  }
+  for ( int i = 0; i < 3; i++ )
+    voicing.notes[i] = (unsigned char) notes[i];
+  return voicing;
+}
+
+constexpr VoicingTable makeVoicingTable( void )
+{
+  VoicingTable table = {};
+  for ( int window = 0; window < REGISTERS; window++ )
+    for ( int tonality = 0; tonality < TONALITIES; tonality++ )
+      for ( int degree = 0; degree < CHORD_DEGREES; degree++ )
+        table.voicings[window][tonality][degree] = makeVoicing( window, tonality, degree );
+  return table;
+}
+
+constexpr VoicingTable VOICINGS = makeVoicingTable();
+
+// A minor (tonality 0), chord i, left hand: C3, E3 and A2 folded up to A3.
+static_assert( VOICINGS.voicings[LEFT_HAND][0][0].notes[0] == 48 &&
+               VOICINGS.voicings[LEFT_HAND][0][0].notes[1] == 52 &&
+               VOICINGS.voicings[LEFT_HAND][0][0].notes[2] == 57,
+               "voicing table is not sorted and folded" );
+
+//! Returns the voicing of chord \e degree (1 to 7) in \e tonality (0 to 11).
+inline const Voicing& getVoicing( Register window, int tonality, int degree )
+{
+  return VOICINGS.voicings[window][tonality][degree - 1];
+}
+
+//! Returns the root of chord \e degree (1 to 7) in \e tonality, above \e baseline.
+constexpr int getRootNote( int tonality, int degree, int baseline )
+{
+  return CHORDS_IN_KEY[degree - 1][0] + tonality + baseline;
+}
+
+#endif
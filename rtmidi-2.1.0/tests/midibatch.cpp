@@ -0,0 +1,119 @@
+//*******************************************************************************************//
+//  midibatch.cpp
+//
+//  Renders a library of Metamorphosis-style pieces (see midiout.cpp) to
+//  Standard MIDI Files, using one worker thread per core.
+//
+//  Every worker owns its generator (and therefore its random number
+//  sequence), timeline and file buffer, so the workers never share any
+//  state.  Piece number i is always seeded with (seed + i), so a batch
+//  is reproducible whatever the number of workers.
+//*******************************************************************************************//
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <pthread.h>
+#include <unistd.h>
+#include "Metamorphosis.h"
+#include "MidiFile.h"
+#include "Playback.h"
+
+void usage( void ) {
+  // Error function in case of incorrect command-line
+  // argument specifications.
+  std::cout << "\nuseage: midibatch N directory <workers> <seed>\n";
+  std::cout << "    where N = the number of pieces to render,\n";
+  std::cout << "    directory = where the pieces are written (piece-000000.mid, ...),\n";
+  std::cout << "    workers = an optional number of worker threads (default = one per core),\n";
+  std::cout << "    and seed = an optional seed for the first piece (default = 1).\n\n";
+  exit( 0 );
+}
+
+// The work assigned to one worker thread.  Worker w renders pieces
+// w, w + nWorkers, w + 2 * nWorkers, ...
+struct BatchWorker {
+  pthread_t thread;
+  unsigned int index;
+  unsigned int nWorkers;
+  unsigned long nPieces;
+  unsigned long long seed;
+  std::string directory;
+  unsigned long rendered;
+  unsigned long failed;
+};
+
+static void *batchWorker( void *ptr )
+{
+  BatchWorker *worker = static_cast<BatchWorker *> (ptr);
+  Metamorphosis generator;
+  Timeline timeline;
+  TempoMap tempo;
+  char fileName[32];
+
+  for ( unsigned long i = worker->index; i < worker->nPieces; i += worker->nWorkers ) {
+    generator.setSeed( worker->seed + i );
+    generator.compose( timeline );
+
+    snprintf( fileName, sizeof(fileName), "/piece-%06lu.mid", i );
+    if ( writeMidiFile( worker->directory + fileName, timeline, tempo ) )
+      worker->rendered++;
+    else
+      worker->failed++;
+  }
+
+  return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+  // Minimal command-line check.
+  if ( argc < 3 || argc > 5 ) usage();
+
+  unsigned long nPieces = strtoul( argv[1], NULL, 10 );
+  std::string directory = argv[2];
+
+  long nCores = sysconf( _SC_NPROCESSORS_ONLN );
+  unsigned int nWorkers = ( nCores > 0 ) ? (unsigned int) nCores : 1;
+  if ( argc > 3 ) nWorkers = (unsigned int) atoi( argv[3] );
+  if ( nWorkers == 0 ) usage();
+  if ( nWorkers > nPieces && nPieces > 0 ) nWorkers = (unsigned int) nPieces;
+
+  unsigned long long seed = 1;
+  if ( argc > 4 ) seed = strtoull( argv[4], NULL, 10 );
+
+  std::vector<BatchWorker> workers( nWorkers );
+  long long begin = DeadlineScheduler::now();
+  for ( unsigned int w = 0; w < nWorkers; w++ ) {
+    workers[w].index = w;
+    workers[w].nWorkers = nWorkers;
+    workers[w].nPieces = nPieces;
+    workers[w].seed = seed;
+    workers[w].directory = directory;
+    workers[w].rendered = 0;
+    workers[w].failed = 0;
+    if ( pthread_create( &workers[w].thread, NULL, batchWorker, &workers[w] ) != 0 ) {
+      std::cout << "Error creating worker thread " << w << "!" << std::endl;
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  unsigned long rendered = 0, failed = 0;
+  for ( unsigned int w = 0; w < nWorkers; w++ ) {
+    pthread_join( workers[w].thread, NULL );
+    rendered += workers[w].rendered;
+    failed += workers[w].failed;
+  }
+  double seconds = ( DeadlineScheduler::now() - begin ) * 0.000000001;
+
+  std::cout << "\nRendered " << rendered << " pieces to " << directory << " with "
+            << nWorkers << " workers in " << seconds << " s ("
+            << ( seconds > 0.0 ? rendered / seconds : 0.0 ) << " pieces/second).\n";
+  if ( failed > 0 ) {
+    std::cout << "Error writing " << failed << " pieces!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
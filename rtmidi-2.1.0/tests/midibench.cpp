@@ -0,0 +1,297 @@
+//*******************************************************************************************//
+//  midibench.cpp
+//
+//  Measures how accurately a Metamorphosis-style piece (see midiout.cpp)
+//  is paced, with each of the pacing strategies of the DeadlineScheduler.
+//
+//  The first measures of a piece are played into a local sink: every
+//  group of events goes through a VoiceTracker into an RtMidiOutQueue,
+//  which is drained at once, and is timestamped when it is sent and
+//  compared with its ideal due time.  The lateness percentiles and the
+//  final drift are printed for each strategy.  No MIDI port is needed,
+//  so the benchmark runs on any machine (-v also sends the drained
+//  events through a virtual port).  With -l, the program fails when the
+//  deadline-based strategies are too late, e.g. to catch timing
+//  regressions in a CI job.
+//
+//  With -m, it instead measures how long the producer threads of an
+//  RtMidiOutQueue take to push a message, with 1, 2, 4, ... threads
+//  feeding the same queue while the main thread drains it.
+//*******************************************************************************************//
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include "RtMidi.h"
+#include "Metamorphosis.h"
+#include "Playback.h"
+#include "TempoMap.h"
+#include "VoiceTracker.h"
+
+void usage( void ) {
+  // Error function in case of incorrect command-line
+  // argument specifications.
+  std::cout << "\nuseage: midibench [-s seed] [-t bpm] [-n measures] [-p pacing] [-w ms] [-l ms] [-m threads] [-v]\n";
+  std::cout << "    where -s seed     = compose the piece from this seed (default = 1),\n";
+  std::cout << "          -t bpm      = the tempo, in quarter notes per minute (default = 120.48),\n";
+  std::cout << "          -n measures = the number of measures played per strategy (default = 8),\n";
+  std::cout << "          -p pacing   = relative, absolute, spin or all (default = all),\n";
+  std::cout << "          -w ms       = the spinning time of the spin-assisted pacing (default = 0.2),\n";
+  std::cout << "          -l ms       = fail if the p99 lateness of the absolute or spin-assisted\n";
+  std::cout << "                        pacing exceeds ms,\n";
+  std::cout << "          -m threads  = measure the pushes to an output queue instead, with up\n";
+  std::cout << "                        to this many producer threads,\n";
+  std::cout << "    and   -v          = also send the events through a virtual output port.\n\n";
+  exit( 0 );
+}
+
+// Lateness statistics of one strategy, in nanoseconds.
+struct BenchResult {
+  unsigned long sends;
+  long long p50;
+  long long p99;
+  long long p999;
+  long long max;
+  long long drift;  // lateness of the last send
+};
+
+// Returns the nearest-rank percentile \e p (0 to 1) of the sorted \e samples.
+static long long percentile( const std::vector<long long> &samples, double p )
+{
+  if ( samples.empty() ) return 0;
+  unsigned long rank = (unsigned long) ( p * samples.size() + 0.999999 );
+  if ( rank < 1 ) rank = 1;
+  if ( rank > samples.size() ) rank = samples.size();
+  return samples[rank - 1];
+}
+
+// Plays the events of \e timeline before \e length with \e scheduler,
+// timestamping every group as it is sent.  Every group is pushed to a
+// queue and drained to \e midiout, or discarded if \e midiout is 0, so
+// that the voice tracking and the send cost are timed either way.
+static BenchResult playPaced( const Timeline &timeline, unsigned long length, const TempoMap &tempo,
+                              DeadlineScheduler &scheduler, RtMidiOut *midiout,
+                              std::vector<long long> &lateness )
+{
+  const std::vector<MidiEvent> &events = timeline.events;
+  unsigned long i = 0, nEvents = events.size();
+  unsigned int segment = 0;
+  VoiceTracker voices;
+  RtMidiOutQueue sink( midiout );
+  BenchResult result;
+
+  lateness.clear();
+  scheduler.start();
+  while ( i < nEvents && events[i].tick < length ) {
+    unsigned long tick = events[i].tick;
+    long long dueTime = tempo.getTime( tick, segment );
+    scheduler.waitUntilTime( dueTime );
+    for ( ; i < nEvents && events[i].tick == tick; i++ )
+      voices.add( events[i] );
+    voices.sendGroup( &sink );
+    sink.drain();
+    lateness.push_back( DeadlineScheduler::now() - ( scheduler.getStartTime() + dueTime ) );
+  }
+  voices.flush( &sink );
+  sink.drain();
+
+  result.sends = lateness.size();
+  result.drift = lateness.empty() ? 0 : lateness.back();
+  std::sort( lateness.begin(), lateness.end() );
+  result.p50 = percentile( lateness, 0.5 );
+  result.p99 = percentile( lateness, 0.99 );
+  result.p999 = percentile( lateness, 0.999 );
+  result.max = lateness.empty() ? 0 : lateness.back();
+  return result;
+}
+
+// Messages pushed by each producer thread with -m.
+const unsigned long PUSHES_PER_PRODUCER = 100000;
+
+// A producer thread of the queue benchmark.
+struct Producer {
+  RtMidiOutQueue *queue;
+  unsigned char channel;
+  std::vector<long long> pushTimes;  // the time each push took, in nanoseconds
+  unsigned long retries;            // pushes refused by a full queue
+};
+
+// Pushes PUSHES_PER_PRODUCER NoteOns and NoteOffs to the queue of a
+// Producer, timing every push, and retries while the queue is full.
+static void *producerThread( void *ptr )
+{
+  Producer *producer = static_cast<Producer *> (ptr);
+  unsigned char message[3];
+  message[0] = 0x90 | producer->channel;
+
+  for ( unsigned long i = 0; i < PUSHES_PER_PRODUCER; i++ ) {
+    message[1] = 36 + i % 48;
+    message[2] = ( i & 1 ) ? 0 : 90;
+    for ( ;; ) {
+      long long begin = DeadlineScheduler::now();
+      bool pushed = producer->queue->push( message, 3 );
+      long long end = DeadlineScheduler::now();
+      if ( pushed ) {
+        producer->pushTimes.push_back( end - begin );
+        break;
+      }
+      producer->retries++;
+    }
+  }
+  return 0;
+}
+
+// Measures the pushes with 1, 2, 4, ... up to \e maxThreads producers,
+// draining the queue to \e midiout (or discarding it if 0).
+static void benchQueue( unsigned int maxThreads, RtMidiOut *midiout )
+{
+  std::cout << "\nPushing " << PUSHES_PER_PRODUCER << " messages per producer thread.\n\n";
+  std::cout << "Producers       pushes     p50 us     p99 us   p99.9 us     max us    retries\n";
+
+  for ( unsigned int nThreads = 1; ; nThreads *= 2 ) {
+    if ( nThreads > maxThreads ) nThreads = maxThreads;
+
+    RtMidiOutQueue queue( midiout );
+    std::vector<Producer> producers( nThreads );
+    std::vector<pthread_t> threads( nThreads );
+    for ( unsigned int i = 0; i < nThreads; i++ ) {
+      producers[i].queue = &queue;
+      producers[i].channel = i % 16;
+      producers[i].pushTimes.reserve( PUSHES_PER_PRODUCER );
+      producers[i].retries = 0;
+    }
+
+    unsigned int started = 0;
+    for ( ; started < nThreads; started++ )
+      if ( pthread_create( &threads[started], NULL, producerThread, &producers[started] ) != 0 ) break;
+
+    // The single consumer.
+    unsigned long drained = 0, total = (unsigned long) started * PUSHES_PER_PRODUCER;
+    while ( drained < total ) {
+      unsigned int count = queue.drain();
+      drained += count;
+      if ( count == 0 ) DeadlineScheduler::sleepUntil( DeadlineScheduler::now() + 100000 );
+    }
+    for ( unsigned int i = 0; i < started; i++ )
+      pthread_join( threads[i], NULL );
+
+    std::vector<long long> pushTimes;
+    unsigned long retries = 0;
+    pushTimes.reserve( total );
+    for ( unsigned int i = 0; i < started; i++ ) {
+      pushTimes.insert( pushTimes.end(), producers[i].pushTimes.begin(), producers[i].pushTimes.end() );
+      retries += producers[i].retries;
+    }
+    std::sort( pushTimes.begin(), pushTimes.end() );
+
+    std::cout << std::left << std::setw( 10 ) << started << std::right
+              << std::setw( 12 ) << pushTimes.size()
+              << std::setw( 11 ) << percentile( pushTimes, 0.5 ) * 0.001
+              << std::setw( 11 ) << percentile( pushTimes, 0.99 ) * 0.001
+              << std::setw( 11 ) << percentile( pushTimes, 0.999 ) * 0.001
+              << std::setw( 11 ) << ( pushTimes.empty() ? 0 : pushTimes.back() ) * 0.001
+              << std::setw( 11 ) << retries << std::endl;
+
+    if ( started < nThreads ) {
+      std::cout << "Error creating the producer threads!" << std::endl;
+      break;
+    }
+    if ( nThreads == maxThreads ) break;
+  }
+}
+
+static void printResult( const std::string &name, const BenchResult &result )
+{
+  std::cout << std::left << std::setw( 18 ) << name << std::right
+            << std::setw( 8 ) << result.sends
+            << std::setw( 11 ) << result.p50 * 0.000001
+            << std::setw( 11 ) << result.p99 * 0.000001
+            << std::setw( 11 ) << result.p999 * 0.000001
+            << std::setw( 11 ) << result.max * 0.000001
+            << std::setw( 11 ) << result.drift * 0.000001 << std::endl;
+}
+
+int main( int argc, char *argv[] )
+{
+  unsigned long long seed = 1;
+  unsigned int nMeasures = 8;
+  std::string pacing = "all";
+  double spinMs = 0.2;
+  double limitMs = -1.0;
+  unsigned int producers = 0;
+  bool virtualPort = false;
+  TempoMap tempo;
+
+  // Minimal command-line check.
+  for ( int i = 1; i < argc; i++ ) {
+    std::string option( argv[i] );
+    if ( option == "-s" && i + 1 < argc ) seed = strtoull( argv[++i], NULL, 10 );
+    else if ( option == "-t" && i + 1 < argc ) tempo.reset( TempoMap::bpmToTickDuration( atof( argv[++i] ) ) );
+    else if ( option == "-n" && i + 1 < argc && atoi( argv[i+1] ) > 0 ) nMeasures = atoi( argv[++i] );
+    else if ( option == "-p" && i + 1 < argc ) pacing = argv[++i];
+    else if ( option == "-w" && i + 1 < argc ) spinMs = atof( argv[++i] );
+    else if ( option == "-l" && i + 1 < argc ) limitMs = atof( argv[++i] );
+    else if ( option == "-m" && i + 1 < argc && atoi( argv[i+1] ) > 0 ) producers = atoi( argv[++i] );
+    else if ( option == "-v" ) virtualPort = true;
+    else usage();
+  }
+  if ( pacing != "relative" && pacing != "absolute" && pacing != "spin" && pacing != "all" ) usage();
+
+  RtMidiOut *midiout = 0;
+  if ( virtualPort ) {
+    try {
+      midiout = new RtMidiOut();
+      midiout->openVirtualPort( "midibench" );
+    }
+    catch ( RtMidiError &error ) {
+      error.printMessage();
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  if ( producers > 0 ) {
+    benchQueue( producers, midiout );
+    delete midiout;
+    return 0;
+  }
+
+  Metamorphosis generator;
+  Timeline timeline;
+  generator.setSeed( seed );
+  generator.compose( timeline );
+  unsigned long length = std::min( (unsigned long) nMeasures, (unsigned long) generator.getMeasureCount() )
+    * TICKS_PER_MEASURE;
+
+  // Room for every send, so that nothing is allocated while a strategy plays.
+  std::vector<long long> lateness;
+  lateness.reserve( timeline.events.size() );
+
+  std::cout << "\nPlaying " << length / TICKS_PER_MEASURE << " measures ("
+            << tempo.getTime( length ) * 0.000000001 << " s) per strategy.\n\n";
+  std::cout << "Pacing               sends     p50 ms     p99 ms   p99.9 ms     max ms   drift ms\n";
+
+  bool failed = false;
+  for ( unsigned int strategy = 0; strategy < 3; strategy++ ) {
+    static const char *names[3] = { "relative", "absolute", "spin" };
+    static const char *labels[3] = { "relative usleep", "absolute deadline", "spin-assisted" };
+    if ( pacing != "all" && pacing != names[strategy] ) continue;
+
+    DeadlineScheduler scheduler;
+    scheduler.setPacing( (DeadlineScheduler::Pacing) strategy, spinMs );
+    BenchResult result = playPaced( timeline, length, tempo, scheduler, midiout, lateness );
+    printResult( labels[strategy], result );
+
+    if ( limitMs >= 0.0 && scheduler.getPacing() != DeadlineScheduler::RELATIVE_SLEEP &&
+         result.p99 * 0.000001 > limitMs ) {
+      std::cout << "  p99 lateness over the " << limitMs << " ms limit!" << std::endl;
+      failed = true;
+    }
+  }
+
+  delete midiout;
+  return failed ? EXIT_FAILURE : 0;
+}
@@ -24,127 +24,141 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <csignal>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
 #include "RtMidi.h"
-
-// Platform-dependent sleep routines.
-#if defined(__WINDOWS_MM__)
-  #include <windows.h>
-  #define SLEEP( milliseconds ) Sleep( (DWORD) milliseconds ) 
-#else // Unix variants
-  #include <unistd.h>
-  #define SLEEP( milliseconds ) usleep( (unsigned long) (milliseconds * 1000.0) )
-#endif
+#include "Metamorphosis.h"
+#include "MeasureStream.h"
+#include "MidiFile.h"
+#include "Playback.h"
+#include "RealtimeThread.h"
+#include "TempoMap.h"
+#include "VoiceTracker.h"
+
+void usage( void ) {
+  // Error function in case of incorrect command-line
+  // argument specifications.
+  std::cout << "\nuseage: midiout [-s seed] [-t bpm] [-p voices] [-r] [-b measure] [-f priority] [-c cpu] [-q ms] [-a] [-e | -o file]\n";
+  std::cout << "    where -s seed = compose the piece from this seed (default = a new seed every run),\n";
+  std::cout << "          -t bpm  = the tempo, in quarter notes per minute (default = 120.48),\n";
+  std::cout << "          -p voices = the most notes sounding at the same time (default = 16),\n";
+  std::cout << "          -r      = use running status on byte-stream ports (Windows MM),\n";
+  std::cout << "          -b measure = start playing at this measure (default = 1),\n";
+  std::cout << "          -f priority = real-time mode: play on a SCHED_FIFO thread with this\n";
+  std::cout << "                    priority, with the memory locked,\n";
+  std::cout << "          -c cpu  = pin the playback thread to this CPU (Linux),\n";
+  std::cout << "          -q ms   = queue each measure this many ms ahead, stamped with its\n";
+  std::cout << "                    due times, for the MIDI API to dispatch (ALSA, JACK),\n";
+  std::cout << "          -a      = asynchronous output: the playback only queues the messages,\n";
+  std::cout << "                    and a transmit thread hands them to the MIDI API,\n";
+  std::cout << "          -e      = endless mode: keep playing new sections, in new tonalities,\n";
+  std::cout << "                    until the program is stopped,\n";
+  std::cout << "    and   -o file = render the piece to a Standard MIDI File\n";
+  std::cout << "                    instead of playing it through a MIDI port.\n\n";
+  exit( 0 );
+}
 
 // This function should be embedded in a try/catch block in case of
 // an exception.  It offers the user a choice of MIDI ports to open.
 // It returns false if there are no ports available.
 bool chooseMidiPort( RtMidiOut *rtmidi );
 
-std::vector<int> ActualChord (int degree, int tonality, int baseline, int upperLimit, int lowLimit, std::vector< std::vector<int> > AllChordsInKey);
+// Prints the tonality and the measures of the composed piece.
+void printArrangement( const Metamorphosis &generator );
+
+// Composes a piece and writes it to a Standard MIDI File, without
+// opening a MIDI port or sleeping.  Returns false if the file could
+// not be written.
+bool renderPiece( const std::string &fileName, unsigned long long seed, const TempoMap &tempo );
+
+// Seconds between two status lines in endless mode.
+const unsigned int STATUS_SECONDS = 60;
+
+// The status thread of the endless mode and how to stop it.
+struct StatusPrinter {
+  MeasureStream *stream;
+  std::mutex mutex;
+  std::condition_variable stopped;
+  bool stopRequested;
+};
+
+// Prints the stream counters every STATUS_SECONDS, so that a long
+// endless run can be watched for underruns, until stopStatus().
+void statusThread( StatusPrinter *printer );
+
+// Stops the status thread, if it runs, and waits for it to finish.
+void stopStatus( StatusPrinter &printer, std::thread &status );
+
+// What the playback thread plays.
+struct Player {
+  RtMidiOut *midiout;
+  MeasureStream *stream;
+  const TempoMap *tempo;
+  DeadlineScheduler *scheduler;
+  VoiceTracker *voices;
+  double aheadMs;  // 0 to send every tick when it is due
+};
+
+// Plays the stream of a Player (see playStream() and playStreamAhead()).
+void *playThread( void *ptr );
+
+// The stream being played, cancelled by Ctrl-C so that the sounding
+// notes can be released before the program exits.
+MeasureStream *playingStream = 0;
+
+void interrupt( int )
+{
+  if ( playingStream ) playingStream->cancel();
+}
 
-int main( void )
+int main( int argc, char *argv[] )
 {
   RtMidiOut *midiout = 0;
-  std::vector<unsigned char> message(3);
-  int duration_eighthNote = 249;
-  int delta1, delta2, delta3;
-  std::vector<int> PlayingChord;
-  int degree, tonality, longNote;
-  std::vector< std::vector<int> > TimeSeq1;
-  std::vector< std::vector<int> > TimeSeq1A(8);
-  std::vector< std::vector<int> > TimeSeq1B(8);
-  std::vector< std::vector<int> > TimeSeq2;
-  std::vector< std::vector<int> > TimeSeq3;
-//------------------------------------------------------------------//
-//------------------------------------------------------------------//
-
-// SO I RESTRICTED THE PROBLEM TO DIATONIC CHORDS (like piece # 2 in Metamorphosis)
-  // THE EASIEST CASE (there is no ornamentations -notes outside the tonality-).
-
-  // I USED A MINOR TONALITY JUST LIKE GLASS IN ALL HIS WORKS IN METAMORPHOSIS
-
-  // AND I RESTRICTED THE CHORD PROGRESSIONS TO THE WAY HE GENERALLY MOVES BETWEEN CHORDS
-  // i --> III, VI --> III, VI or iv, ii-
-  // iv and ii- --> can move to themselves or to VII, v
-  // And VII, v --> can move to themselves or return to i
-  // I DIDN'T USE ALL THESE CASES BUT SOME OF THEM IN ORDER TO RANDOMLY HAVE 
-  // DIFFERENT SEQUENCES OF CHORDS IN A PROGRESSION SIMILAR TO THIS ONE.
-  // TO ACTUALLY ALLOW THIS KIND OF IMPLEMENTATION (with ALL cases allowed by Glass)
-  // WE SHOULD MAKE USE OF MARKOV CHAINS, WHERE EACH NEXT CHORD HAS A WEIGHT ASSOCIATED TO IT
-  
-  //--------------------//
-  //  CHORD PROGRESSION //
-  //--------------------//
-
-  // Vector that contains all the kinds of chord progressions allowed in the piece
-  // Each vector inside it (AllChordProgressions) has numbers that indicate the scale degree of the root note of each chord.
-  std::vector< std::vector<int> > AllChordProgressions(5);
-  std::vector<int> chord1(1,1);
-  std::vector<int> chord2(2);
-  chord2[0] = 3;
-  chord2[1] = 6;
-  //std::vector<int> chord3(4);
-  std::vector<int> chord3(2);
-  chord3[0] = 3;
-  chord3[1] = 6;
-  //chord3[2] = 4;
-  //chord3[3] = 2;
-  std::vector<int> chord4(2);
-  chord4[0] = 5;
-  chord4[1] = 7;
-
-  AllChordProgressions[0] = chord1;
-  AllChordProgressions[1] = chord2;
-  AllChordProgressions[2] = chord3;
-  AllChordProgressions[3] = chord4;
-  AllChordProgressions[4] = chord1;
-  // Chord progression: {i} --> {III, VI} --> {III, VI, iv, ii-} --> {v, VII} --> Again {i}
-  // Chord progression: {1} --> {3, 6} --> {3, 6, 4, 2} --> {5, 7} --> Again {1}
-
-
-  //----------------------------------------//
-  // ALL THE POSSIBLE CHORDS IN A MINOR KEY //
-  //----------------------------------------//
-
-  std::vector< std::vector<int> > AllChordsInKey(7);
-  std::vector<int> chord(3);
-  // i  = {root = 0, mode = minor}
-  chord[0] = 0;
-  chord[1] = (chord[0] + 3) % 12;
-  chord[2] = (chord[0] + 7) % 12;
-  AllChordsInKey[0] = chord;
-  // ii-  = {root = 2, mode = diminished}
-  chord[0] = 2;
-  chord[1] = (chord[0] + 3) % 12;
-  chord[2] = (chord[0] + 6) % 12;
-  AllChordsInKey[1] = chord;
-  // III  = {root = 3, mode = Major}
-  chord[0] = 3;
-  chord[1] = (chord[0] + 4) % 12;
-  chord[2] = (chord[0] + 7) % 12;
-  AllChordsInKey[2] = chord;
-  // iv = {root = 5, mode = minor}
-  chord[0] = 5;
-  chord[1] = (chord[0] + 3) % 12;
-  chord[2] = (chord[0] + 7) % 12;
-  AllChordsInKey[3] = chord;
-  // v  = {root = 7, mode = minor}
-  chord[0] = 7;
-  chord[1] = (chord[0] + 3) % 12;
-  chord[2] = (chord[0] + 7) % 12;
-  AllChordsInKey[4] = chord;
-  // VI   = {root = 8, mode = Major}
-  chord[0] = 8;
-  chord[1] = (chord[0] + 4) % 12;
-  chord[2] = (chord[0] + 7) % 12;
-  AllChordsInKey[5] = chord;
-  // VII  = {root = 10, mode = Major}
-  chord[0] = 10;
-  chord[1] = (chord[0] + 4) % 12;
-  chord[2] = (chord[0] + 7) % 12;
-  AllChordsInKey[6] = chord;
-//------------------------------------------------------------------//
-//------------------------------------------------------------------//
+  DeadlineScheduler scheduler;
+  Metamorphosis generator;
+  MeasureStream stream;
+  VoiceTracker voices;
+  TempoMap tempo;
+  std::string fileName;
+  bool endless = false;
+  bool runningStatus = false;
+  bool async = false;
+  unsigned int firstBar = 0;
+  int priority = 0;
+  int cpu = -1;
+  double aheadMs = 0.0;
+  RealtimeThread sender;
+  Player player;
+  StatusPrinter printer;
+  std::thread status;
+
+  // A new seed every time the program runs, unless one is given.
+  unsigned long long seed = (unsigned long long) DeadlineScheduler::now();
+
+  // Minimal command-line check.
+  for ( int i = 1; i < argc; i++ ) {
+    std::string option( argv[i] );
+    if ( option == "-o" && i + 1 < argc ) fileName = argv[++i];
+    else if ( option == "-s" && i + 1 < argc ) seed = strtoull( argv[++i], NULL, 10 );
+    else if ( option == "-t" && i + 1 < argc ) tempo.reset( TempoMap::bpmToTickDuration( atof( argv[++i] ) ) );
+    else if ( option == "-p" && i + 1 < argc ) voices.setMaxVoices( atoi( argv[++i] ) );
+    else if ( option == "-b" && i + 1 < argc && atoi( argv[i+1] ) > 0 ) firstBar = atoi( argv[++i] ) - 1;
+    else if ( option == "-f" && i + 1 < argc ) priority = atoi( argv[++i] );
+    else if ( option == "-c" && i + 1 < argc ) cpu = atoi( argv[++i] );
+    else if ( option == "-q" && i + 1 < argc ) aheadMs = atof( argv[++i] );
+    else if ( option == "-e" ) endless = true;
+    else if ( option == "-r" ) runningStatus = true;
+    else if ( option == "-a" ) async = true;
+    else usage();
+  }
+  if ( ( endless || firstBar > 0 || priority > 0 || cpu >= 0 || aheadMs > 0.0 || async ) && !fileName.empty() ) usage();
+
+  if ( !fileName.empty() )
+    return renderPiece( fileName, seed, tempo ) ? 0 : EXIT_FAILURE;
 
   // RtMidiOut constructor
   try {
@@ -164,382 +178,140 @@ int main( void )
     goto cleanup;
   }
 
-  // Send out a series of MIDI messages.
-//------------------------------------------------------------------//
-
-
-  //---------------------//
-  // CHOOSING A TONALITY //
-  //---------------------//
-
-  srandomdev(); // seed the random number generator (every time the program runs)
-  
-  // Obtains a random number between 0 and 11 
-  // that corresponds to one tonality, where:
-  // 0 is A,    1 is A#,  2 is B,   3 is C,   4 is C#,  5 is D,
-  // 6 is D#,   7 is E,   8 is F,   9 is F#,  10 is G,  11 is G#
-  tonality = random()%12; 
-
-//-----------------------------------------------------------------------------------------//
-
-  //----------------------//
-  //    FIRST PART        //
-  //----------------------//----------------------------------------------//
-  // This part is always in the FIRST chord (i) of the key (or tonality)  //
-  // Here there are no chord progressions,                                //
-  // we are always in i: AllChordsInKey[0]                                //
-  // the right hand plays (when it does) the root of the chord i          //
-  //----------------------------------------------------------------------//
-  
-  // LEFT HAND:
-  // ----------
-  // Generates the actual chord to be played in the limits
-  PlayingChord = ActualChord (1, tonality, 45, 59, 48, AllChordsInKey);
-  // For the FIRST PART we are always playing CHORD i
-  // Limits in range: C3 (48) to B3 (59)
-  // So its baseline (given that 0 is A) is: A2 = 45
-
-  //ordering vector from lowest to highest value (increasing pitch)
-  std::sort(PlayingChord.begin(),PlayingChord.end()); 
-  // The 1st note is the lowest --> used as bass (quarter note) 
-  // Last 2 notes are the highest --> used as the eighth notes (played over the quarter note)
-
-  // RIGHT HAND:
-  // -----------
-  //Base line for the RIGHT HAND: A0 = 21
-  longNote = 0 + tonality + 21;
-
-  //  RYTHM:
-  // -------
-  for (unsigned int i = 0; i < TimeSeq1A.size(); i++){
-    std::vector<int> subvector;
-    // PART A
-    if(i%2 == 0){
-      subvector.push_back(PlayingChord[0]); //Quarter
-      subvector.push_back(PlayingChord[1]); //low Eighth note
-    }else{
-      subvector.push_back(PlayingChord[2]); //high Eighth note
-    }
-    TimeSeq1A[i] = subvector;
-    // PART B
-    if(i == 0){
-      subvector.push_back(longNote);
-      subvector.push_back(longNote + 12);
-    }
-    TimeSeq1B[i] = subvector;
-  }
-  TimeSeq1.insert(TimeSeq1.end(), TimeSeq1A.begin(), TimeSeq1A.end());
-  TimeSeq1.insert(TimeSeq1.end(), TimeSeq1A.begin(), TimeSeq1A.end());
-  TimeSeq1.insert(TimeSeq1.end(), TimeSeq1B.begin(), TimeSeq1B.end());
-  TimeSeq1.insert(TimeSeq1.end(), TimeSeq1A.begin(), TimeSeq1A.end());
-
-  // Verification
-  std::cout << tonality << std::endl;
-  for (unsigned int i = 0; i < TimeSeq1.size(); i++){
-    for (unsigned int j = 0; j < TimeSeq1[i].size(); j++){
-      std::cout << TimeSeq1[i][j] << ", ";  
-    }std::cout << std::endl;
-  }
-    
-  // MIDI MESSAGE:
-  // -------------
-  delta1 = duration_eighthNote;
-  // NoteOn or NoteOff
-  message[0] = 144;
-  // TimeSeq1 is played 2 times:
-  for (unsigned int ntimes = 1; ntimes <= 2; ntimes++){
-    // Velocity - NoteOn:
-    message[2] = 100; //Velocity for the FIRST NOTE in the sequence
-    for (unsigned int i = 0; i < TimeSeq1.size(); i++){
-      // All notes that should begin at the same time:
-      for (unsigned int j = 0; j < TimeSeq1[i].size(); j++){
-        message[1] = TimeSeq1[i][j];
-        
-        //To give more volume to the notes on the RIGHT HAND 
-        //(which are much more lower in the scale)
-        if(j>=2){message[2] = 115;}
-        
-        //SEND MESSAGE (for now)
-        midiout->sendMessage( &message );
-      }
-      SLEEP(delta1);
-      message[2] = 80;
-    }
-  }
-
-  //----------------------//
-  //    SECOND PART       //
-  //----------------------//----------------------------------//
-  // This part moves from chord to chord in each measure,     //
-  // so it follows the possible chord progressions defined    //
-  // in the vector AllChordProgressions                       //
-  // The left hand behaves just like before                   //
-  // (that is why we have same code for it)                   //
-  // and the right hand plays the whole chord                 //
-  // (in an upper register -approx. C3 to C4-)                //
-  //----------------------------------------------------------//
-  for (unsigned int nmeasure = 0; nmeasure < AllChordProgressions.size(); nmeasure++){
-    std::vector<int> possible_degrees = AllChordProgressions[nmeasure];
-    degree = possible_degrees[random() % possible_degrees.size()];
-
-    // LEFT HAND:
-    // ----------
-    // Generates the actual chord to be played in the limits
-    std::vector<int> LPlayingChord = ActualChord (degree, tonality, 45, 59, 48, AllChordsInKey);
-  	// For the SECOND PART we have chord progressions (degree)
-  	// Limits in range: C3 (48) to B3 (59)
-	// So its baseline (given that 0 is A) is: A2 = 45
-
-    //ordering vector from lowest to highest value (increasing pitch)
-    std::sort(LPlayingChord.begin(),LPlayingChord.end());     
-    // The 1st note is the lowest --> used as bass (quarter note) 
-    // Last 2 notes are the highest --> used as the eighth notes (played over the quarter)
-
-
-    // RIGHT HAND:
-    // -----------
-	// Generates the actual chord to be played in the limits
-    std::vector<int> RPlayingChord = ActualChord (degree, tonality, 69, 74, 60, AllChordsInKey);
-	// For the SECOND PART we have chord progressions (degree)
-	// Limits in range: C4 (60) to D5 (74)
-	// So its baseline (given that 0 is A) is: A4 = 69
-    //No need to order these notes
-
-
-    //  RYTHM:
-    // -------
-
-    std::vector< std::vector<int> > TimeSeq2C(8);
-    for (unsigned int i = 0; i < TimeSeq2C.size(); i++){
-      std::vector<int> subvector;
-      //Left hand information
-      if(i%2 == 0){
-        subvector.push_back(LPlayingChord[0]);  //Quarter
-        subvector.push_back(LPlayingChord[1]);  //low Eighth note
-      }else{
-        subvector.push_back(LPlayingChord[2]);  //high Eighth note
-      }
-      //Right hand information
-      if(i == 0 or i == 1 or i == 3 or i == 5 or i == 7){
-        for (unsigned int indexNote = 0; indexNote < RPlayingChord.size(); indexNote++){
-          subvector.push_back(RPlayingChord[indexNote]);
-        }
-      }
-      TimeSeq2C[i] = subvector;
-    }
-    TimeSeq2.insert(TimeSeq2.end(), TimeSeq2C.begin(), TimeSeq2C.end());
-
-    // Verification
-    std::cout << "Degree: " << degree << std::endl;
-    for (unsigned int i = 0; i < TimeSeq2C.size(); i++){
-      for (unsigned int j = 0; j < TimeSeq2C[i].size(); j++){
-        std::cout << TimeSeq2C[i][j] << ", ";  
-      }std::cout << std::endl;
-    }
-  }
+  midiout->setRunningStatus( runningStatus );
+  if ( async ) midiout->setAsync( true );
+  generator.setSeed( seed );
+  generator.setEndless( endless );
 
-  // MIDI MESSAGE:
-  // -------------
-  delta2 = duration_eighthNote;
-  // NoteOn or NoteOff
-  message[0] = 144;
-  // Velocity:
-  message[2] = 80;//NoteOn
-  // TimeSeq2 and TimeSeq1B (bridge section) are played 2 times:
-  for (unsigned int ntimes = 1; ntimes <= 2; ntimes++){
-    for (unsigned int i = 0; i < TimeSeq2.size(); i++){
-      // All notes that should begin at the same time:
-      for (unsigned int j = 0; j < TimeSeq2[i].size(); j++){
-        message[1] = TimeSeq2[i][j];
-        midiout->sendMessage( &message );
-      }SLEEP(delta2);
-    }// After TimeSeq2 has being played, TimeSeq1B is played to serve as a bridge between this and the next section
-    for (unsigned int i = 0; i < TimeSeq1B.size(); i++){
-    	for (unsigned int j = 0; j < TimeSeq1B[i].size(); j++){
-    		message[1] = TimeSeq1B[i][j];
-        //To give more volume to the notes on the RIGHT HAND 
-        //(which are much more lower in the scale)
-    		if(j>=2){message[2] = 115;}
-    		midiout->sendMessage( &message );
-    	}SLEEP(delta2);
-    	message[2] = 80;
-    }
+  // Choose the arrangement and start rendering the measures, just
+  // ahead of the playback, on the generator thread.
+  if ( stream.start( generator, tempo.getTickDuration( 0 ) * 0.000001, firstBar ) == false ) {
+    std::cout << "Error creating the generator thread!" << std::endl;
+    goto cleanup;
   }
 
-  //------------------//
-  //    THIRD PART    //
-  //------------------//--------------------------------------------------//
-  // This part changes chord in every measure, the chord progressions   	//
-  // are similar to the ones described by AllChordProgressions            //
-  // The Left hand does what it has been doing all this time              //
-  // (Low Quarter notes and Eighth notes moving a little higher than it)  //
-  // The Right hand plays Triplets over each Eighth note.         		    //
-  //----------------------------------------------------------------------//
-  
-  
-  for (unsigned int nmeasure = 0; nmeasure < AllChordProgressions.size(); nmeasure++){
-    std::vector<int> possible_degrees = AllChordProgressions[nmeasure];
-    degree = possible_degrees[random() % possible_degrees.size()];
-
-    // LEFT HAND:
-    // ----------
-    // Generates the actual chord to be played in the limits
-    std::vector<int> LPlayingChord = ActualChord (degree, tonality, 45, 59, 48, AllChordsInKey);
-    // For the THIRD PART we have chord progressions (degree)
-  	// Limits in range: C3 (48) to B3 (59)
-	// So its baseline (given that 0 is A) is: A2 = 45
-
-    //ordering vector from lowest to highest value (increasing pitch)
-    std::sort(LPlayingChord.begin(),LPlayingChord.end()); 
-    // The 1st note is the lowest --> used as bass (quarter note) 
-    // Last 2 notes are the highest --> used as the eighth notes (played over the quarter)
-
-
-    // RIGHT HAND:
-    // -----------
-    // Generates the actual chord to be played in the limits
-    std::vector<int> RPlayingChord = ActualChord (degree, tonality, 69, 76, 65, AllChordsInKey);
-    // For the THIRD PART we have chord progressions (degree)
-  	// Limits in range: F4 (65) to E5 (76)
-	// So its baseline (given that 0 is A) is: A4 = 69
-    
-    //ordering vector from lowest to highest value (increasing pitch)
-    std::sort(RPlayingChord.begin(),RPlayingChord.end()); 
-
-    RPlayingChord.push_back(RPlayingChord[0] + 12);
-    RPlayingChord.push_back(RPlayingChord[2]);
-    RPlayingChord.push_back(RPlayingChord[1]);
-    // So RPlayingChord has 6 notes, 
-    // 2 triplets corresponding to each Eighth note in the Left Hand
-    // It moves along the chord notes, first in an upward direction: 
-    // 1st --> 2nd --> 3rd  (lowest to highest)
-    // [in order to get to the 1st again but an octave higher]
-    // and then it moves in the downward direction:
-    // 1st (one octave higher) --> 3nd --> 2nd
-    // [in order to begin again with the 1st in the original octave]
-
-
-    //  RYTHM:
-    // -------
-    std::vector< std::vector<int> > TimeSeq3C(24);  
-    // The smallest unit in the Third Part is the 
-    // sixteenth note (as part of a triplet group)
-    // So we divide this part in 24 sections, corresponding to:
-    // 8 eighth notes * 3 triplet = 24 units on each measure.
-    for (unsigned int i = 0; i < TimeSeq3C.size(); i++){
-      std::vector<int> subvector;
-      //Left hand information
-      if(i%6 == 0){
-        subvector.push_back(LPlayingChord[0]);  //Left: Quarter
-        subvector.push_back(LPlayingChord[1]);  //Left: Low Eighth note
-        subvector.push_back(RPlayingChord[0]);  //Right Hand (1st note)
-      }else if(i%6 == 1){
-        subvector.push_back(RPlayingChord[1]);  //Right Hand (2nd note)
-      }else if(i%6 == 2){
-        subvector.push_back(RPlayingChord[2]);  //Right Hand (3rd note)
-      }else if(i%6 == 3){
-        subvector.push_back(LPlayingChord[2]);  //Left: High Eighth note
-        subvector.push_back(RPlayingChord[3]);  //Right Hand (4th note = 1st note an octave higher)
-      }else if(i%6 == 4){
-        subvector.push_back(RPlayingChord[4]);  //Right Hand (5th note)
-      }else{
-        subvector.push_back(RPlayingChord[5]);  //Right Hand (6th note)
-      }
-      TimeSeq3C[i] = subvector;
-    }
-    TimeSeq3.insert(TimeSeq3.end(), TimeSeq3C.begin(), TimeSeq3C.end());
-
-    // Verification
-    std::cout << "Degree: " << degree << std::endl;
-    for (unsigned int i = 0; i < TimeSeq3C.size(); i++){
-      for (unsigned int j = 0; j < TimeSeq3C[i].size(); j++){
-        std::cout << TimeSeq3C[i][j] << ", ";  
-      }std::cout << std::endl;
+  // Verification
+  printArrangement( generator );
+  printer.stream = &stream;
+  printer.stopRequested = false;
+  if ( endless ) {
+    try {
+      status = std::thread( statusThread, &printer );
     }
-  }
-
-  // MIDI MESSAGE:
-  // -------------
-  delta3 = duration_eighthNote/3; //We are going in triplets
-  // NoteOn or NoteOff
-  message[0] = 144;
-  // Velocity:
-  message[2] = 80;//NoteOn
-  // TimeSeq3 and the bridge section (which now consist of both TimeSeq1B and TimeSeq1A) are played 2 times:
-  for (unsigned int ntimes = 1; ntimes <= 2; ntimes++){
-    for (unsigned int i = 0; i < TimeSeq3.size(); i++){
-      // All notes that should begin at the same time:
-      for (unsigned int j = 0; j < TimeSeq3[i].size(); j++){
-        message[1] = TimeSeq3[i][j];
-        //SEND MESSAGE (for now)
-        midiout->sendMessage( &message );
-      }SLEEP(delta3);
-    }//BRIDGE SECTION:
-    for (unsigned int i = 0; i < TimeSeq1B.size(); i++){
-    	for (unsigned int j = 0; j < TimeSeq1B[i].size(); j++){
-    		message[1] = TimeSeq1B[i][j];
-        //To give more volume to the notes on the RIGHT HAND 
-        //(which are much more lower in the scale)
-    		if(j>=2){message[2] = 115;}
-    		midiout->sendMessage( &message );
-    	}SLEEP(delta1);
-    	message[2] = 80;
+    catch ( std::system_error & ) {
+      std::cout << "Error creating the status thread!" << std::endl;
     }
-    for (unsigned int i = 0; i < TimeSeq1A.size(); i++){
-    	for (unsigned int j = 0; j < TimeSeq1A[i].size(); j++){
-    		message[1] = TimeSeq1A[i][j];
-    		midiout->sendMessage( &message );
-    	}SLEEP(delta1);
-    	message[2] = 80;
-    }//ENDING OF BRIDGE SECTION.
   }
-
-  //----------------//
-  //    ENDING    	//
-  //----------------//
-
-  // MIDI MESSAGE:
-  // -------------
-  for (unsigned int ntimes = 1; ntimes <= 2; ntimes++){
-    // Velocity - NoteOn:
-    message[2] = 90; //Velocity for the FIRST NOTE in the sequence
-    for (unsigned int i = 0; i < TimeSeq1.size(); i++){
-      // All notes that should begin at the same time:
-      for (unsigned int j = 0; j < TimeSeq1[i].size(); j++){
-        message[1] = TimeSeq1[i][j];
-        
-        //To give more volume to the notes on the RIGHT HAND 
-        //(which are much more lower in the scale)
-        if(j>=2){message[2] = 115;}
-        
-        //SEND MESSAGE (for now)
-        midiout->sendMessage( &message );
-      }
-      SLEEP(delta1);
-      message[2] = 70;
-    }
+  playingStream = &stream;
+  signal( SIGINT, interrupt );
+
+  // Send out the piece as it is generated, on its own thread.  Every
+  // tick waits for its absolute due time rather than sleeping a relative
+  // delta after sending.
+  player.midiout = midiout;
+  player.stream = &stream;
+  player.tempo = &tempo;
+  player.scheduler = &scheduler;
+  player.voices = &voices;
+  player.aheadMs = aheadMs;
+  sender.setPriority( priority );
+  sender.setCpu( cpu );
+  sender.setLockMemory( priority > 0 );
+  if ( sender.run( playThread, &player ) == false ) {
+    std::cout << "Error creating the playback thread!" << std::endl;
+    goto cleanup;
   }
 
-//------------------------------------------------------------------//
-//------------------------------------------------------------------//
+  // Release whatever is still sounding (after Ctrl-C).
+  stopStatus( printer, status );
+  voices.flush( midiout );
+  midiout->flush();
+  sender.printReport();
+  scheduler.printReport();
+  std::cout << "  stolen voices: " << voices.getStolenVoices()
+            << " (at most " << voices.getMaxVoices() << " voices)" << std::endl;
+  if ( midiout->getBufferSize() > 0 )
+    std::cout << "  output buffer: " << midiout->getBufferHighWater() << " of "
+              << midiout->getBufferSize() << " bytes at most, "
+              << midiout->getDroppedMessages() << " messages dropped" << std::endl;
 
   // Clean up
  cleanup:
+  stopStatus( printer, status );
   delete midiout;
 
   return 0;
 }
 
-std::vector<int> ActualChord (int degree, int tonality, int baseline, int upperLimit, int lowLimit, std::vector< std::vector<int> > AllChordsInKey){
-  int note;
-  std::vector<int> PlayingChord;
-  for (unsigned int i = 0; i < 3; i++){
-    note = AllChordsInKey[degree-1][i] + tonality + baseline;
-    if(note > upperLimit){note = note - 12;}
-    if(note < lowLimit){note = note + 12;}
-    PlayingChord.push_back(note);
+bool renderPiece( const std::string &fileName, unsigned long long seed, const TempoMap &tempo )
+{
+  Metamorphosis generator;
+  Timeline timeline;
+
+  long long begin = DeadlineScheduler::now();
+  generator.setSeed( seed );
+  generator.compose( timeline );
+  if ( writeMidiFile( fileName, timeline, tempo ) == false ) {
+    std::cout << "Error writing " << fileName << "!" << std::endl;
+    return false;
+  }
+  long long end = DeadlineScheduler::now();
+
+  printArrangement( generator );
+  std::cout << "\nRendered " << timeline.events.size() << " events ("
+            << tempo.getTime( timeline.length ) * 0.000000001 << " s of music) to " << fileName
+            << " in " << ( end - begin ) * 0.000001 << " ms ("
+            << generator.getCachedMeasureCount() << " distinct measures)." << std::endl;
+  return true;
+}
+
+void *playThread( void *ptr )
+{
+  Player *player = static_cast<Player *> (ptr);
+  if ( player->aheadMs > 0.0 )
+    playStreamAhead( player->midiout, *player->stream, *player->tempo, *player->scheduler,
+                     *player->voices, player->aheadMs );
+  else
+    playStream( player->midiout, *player->stream, *player->tempo, *player->scheduler, *player->voices );
+  return 0;
+}
+
+void statusThread( StatusPrinter *printer )
+{
+  MeasureStream *stream = printer->stream;
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock( printer->mutex );
+
+  for ( ;; ) {
+    next += std::chrono::seconds( STATUS_SECONDS );
+    if ( printer->stopped.wait_until( lock, next, [printer] { return printer->stopRequested; } ) )
+      break;
+    std::cout << "Measures generated: " << stream->getMeasuresGenerated()
+              << ", underruns: " << stream->getUnderruns()
+              << ", queued: " << stream->getQueuedMeasures() << std::endl;
+  }
+}
+
+void stopStatus( StatusPrinter &printer, std::thread &status )
+{
+  if ( !status.joinable() ) return;
+  {
+    std::lock_guard<std::mutex> lock( printer.mutex );
+    printer.stopRequested = true;
+  }
+  printer.stopped.notify_one();
+  status.join();
+}
+
+void printArrangement( const Metamorphosis &generator )
+{
+  std::cout << "Seed: " << generator.getSeed() << std::endl;
+  std::cout << "Tonality: " << generator.getTonality() << std::endl;
+  for ( unsigned int i = 0; i < generator.getMeasureCount(); i++ ) {
+    const Metamorphosis::Measure &measure = generator.getMeasure( i );
+    std::cout << "Measure " << i + 1 << ": " << Metamorphosis::getPatternName( measure.pattern )
+              << ", Degree: " << measure.degree << std::endl;
   }
-  return PlayingChord;
 }
 
 bool chooseMidiPort( RtMidiOut *rtmidi )